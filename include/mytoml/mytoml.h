@@ -117,6 +117,7 @@
 //-----------------------------------------------------------------------------
 
 #include <stdbool.h> //
+#include <stdint.h>  // for int64_t
 #include <stdio.h>   // for FILE
 
 #include "../khash.h"
@@ -137,39 +138,29 @@
 //-----------------------------------------------------------------------------
 
 /**
- * @def MYTOML_MAX_DATE_FORMAT
- * @brief Maximum length for date format strings.
- * @note Default is 64 [`2^6`].
+ * @def MYTOML_MAX_NUMBER_LENGTH
+ * @brief Maximum length for TOML number values.
+ * @note Default is 4096 [`2^12`]. String values are not limited.
  */
-#define MYTOML_MAX_DATE_FORMAT 64
-
-/**
- * @def MYTOML_MAX_ID_LENGTH
- * @brief Maximum length for TOML key identifiers.
- * @note Default is 256 [`2^8`].
- */
-#define MYTOML_MAX_ID_LENGTH 256
-
-/**
- * @def MYTOML_MAX_STRING_LENGTH
- * @brief Maximum length for TOML string values.
- * @note Default is 4096 [`2^12`].
- */
-#define MYTOML_MAX_STRING_LENGTH 4096
+#define MYTOML_MAX_NUMBER_LENGTH 4096
 
 /**
  * @def MYTOML_MAX_FILE_SIZE
  * @brief Maximum TOML file size in bytes.
- * @note Default is 1073741824 [`2^30`] (1GB).
+ * @note Default is 1073741824 [`2^30`] (1GB). The same bound applies to the
+ * buffers passed to toml_loads_n(), toml_parse_ex() and toml_parse_parallel(),
+ * and to every piece passed to toml_stream_feed().
  */
 #define MYTOML_MAX_FILE_SIZE 1073741824
 
 /**
- * @def MYTOML_MAX_NUM_LINES
- * @brief Maximum number of lines in a TOML file.
- * @note Default is 16777216 [`2^24`].
+ * @def MYTOML_MAX_STREAM_CARRY
+ * @brief Maximum number of bytes a TomlStream holds on to between feeds.
+ * @note Default is 16777216 [`2^24`] (16MB). Only a statement that is not
+ * complete yet is held, so this bounds the size of a single statement, such
+ * as a multi-line string or array, of a streamed document.
  */
-#define MYTOML_MAX_NUM_LINES 16777216
+#define MYTOML_MAX_STREAM_CARRY 16777216
 
 /**
  * @def MYTOML_MAX_SUBKEYS
@@ -179,11 +170,19 @@
 #define MYTOML_MAX_SUBKEYS 131072
 
 /**
- * @def MYTOML_MAX_ARRAY_LENGTH
- * @brief Maximum length of TOML arrays.
- * @note Default is 131072 [`2^17`].
+ * @def MYTOML_TABLE_INDEX_THRESHOLD
+ * @brief Number of subkeys past which a TOML key gets a hash index.
+ * @note Default is 8 [`2^3`]. Smaller tables are searched linearly.
  */
-#define MYTOML_MAX_ARRAY_LENGTH 131072
+#define MYTOML_TABLE_INDEX_THRESHOLD 8
+
+/**
+ * @def MYTOML_ARRAY_INITIAL_CAPACITY
+ * @brief Number of element slots allocated for the first element of a TOML
+ * array.
+ * @note Default is 4 [`2^2`]. Arrays double their capacity when full.
+ */
+#define MYTOML_ARRAY_INITIAL_CAPACITY 4
 
 //-----------------------------------------------------------------------------
 // [SECTION] Function Macros
@@ -299,7 +298,7 @@
  * @code
  * TomlKey *toml = toml_load("basic.toml");
  * if (toml == NULL) return 1;
- * char *buffer = "";
+ * char *buffer = NULL;
  * size_t size = 0;
  * toml_dump_buffer(toml, &buffer, &size);
  * printf("%s\n", buffer);
@@ -321,6 +320,24 @@
       TomlKey *: toml_key_dump_buffer,         \
       TomlValue *: toml_value_dump_buffer)(object, buffer, size)
 
+/**
+ * @brief Macro to iterate over the subkeys of a TOML key in document order.
+ * @param[out] subkey `TomlKey *` variable set to each subkey in turn.
+ * @param[in] key TOML key whose subkeys to visit.
+ * @see toml_key_count, toml_key_at
+ *
+ * Example usage:
+ * @code
+ * TomlKey *sub;
+ * toml_key_foreach(sub, toml) { printf("%s\n", sub->id); }
+ * @endcode
+ */
+#define toml_key_foreach(subkey, key)                                \
+  for (int toml_key_foreach_i_ = 0;                                  \
+       toml_key_foreach_i_ < toml_key_count(key) &&                  \
+       ((subkey) = toml_key_at((key), toml_key_foreach_i_)) != NULL; \
+       toml_key_foreach_i_++)
+
 //-----------------------------------------------------------------------------
 // [SECTION] Platform
 //-----------------------------------------------------------------------------
@@ -617,7 +634,7 @@ typedef enum TomlValueType_t
   TOML_DATETIME,     /**< Datetime value type (RFC 3339). */
   TOML_DATELOCAL,    /**< Local date value type. */
   TOML_TIMELOCAL,    /**< Local time value type. */
-  TOML_INLINETABLE,  /**< Inline table value type. */
+  TOML_INLINETABLE,  /**< Inline table value type, for array elements. */
   TOML_DATETIMELOCAL /**< Local datetime value type. */
 } TomlValueType;
 
@@ -649,6 +666,7 @@ typedef enum TomlErrorType
    */
 
   TOML_UNKNOWN = -1, /**< An unknown error type. */
+  TOML_OK,           /**< No error occured. */
   TOML_DECODE,       /**< Cannot decode the input stream. */
   TOML_ENCODE,       /**< Cannot encode the input stream. */
   TOML_MEMORY,       /**< Cannot allocate or reallocate a block of memory. */
@@ -666,6 +684,38 @@ typedef enum TomlErrorType
 
 } TomlErrorType;
 
+/**
+ * @name TomlDatetime data type
+ * @{
+ */
+
+/**
+ * @def TOML_DATETIME_ZULU
+ * @brief Flag set on a TomlDatetime whose offset was written as `Z`.
+ */
+#define TOML_DATETIME_ZULU 0x01
+
+/**
+ * @struct TomlDatetime
+ * @brief Represents the fields of a TOML datetime, date or time.
+ * @details Fields that are not part of the value type are 0, e.g. the date of
+ * a TOML_TIMELOCAL or the offset of a TOML_DATETIMELOCAL.
+ */
+typedef struct TomlDatetime_t
+{
+  int16_t year;        /**< Year, e.g. 1979. */
+  uint8_t month;       /**< Month of the year [1, 12]. */
+  uint8_t day;         /**< Day of the month [1, 31]. */
+  uint8_t hour;        /**< Hours since midnight [0, 23]. */
+  uint8_t minute;      /**< Minutes after the hour [0, 59]. */
+  uint8_t second;      /**< Seconds after the minute [0, 60]. */
+  uint8_t flags;       /**< `TOML_DATETIME_*` flags. */
+  int16_t offset;      /**< Offset from UTC in minutes (TOML_DATETIME). */
+  uint32_t nanosecond; /**< Fractional seconds in nanoseconds. */
+} TomlDatetime;
+
+/** @} */
+
 /**
  * @name TomlValue data type
  * @{
@@ -675,19 +725,33 @@ typedef enum TomlErrorType
  * @struct TomlValue
  * @brief Represents a TOML value and its associated metadata.
  * @details Used to store any TOML value type, including arrays, numbers,
- * strings, and datetimes.
+ * strings, and datetimes. Scalars are stored inline in the union member that
+ * matches `type`; strings and arrays point to storage of `len` elements.
  */
 typedef struct TomlValue_t TomlValue;
 struct TomlValue_t
 {
   TomlValueType type; /**< Type of TOML value. */
-  TomlValue **arr;    /**< Array of TOML values (for TOML_ARRAY type). */
-  int len;            /**< Length of array or value. */
-  void *data;         /**< Pointer to value data (non-array types). */
-  int precision;      /**< Numeric precision for floating-point values. */
+  int16_t precision;  /**< Fraction digits of a float or datetime. */
   bool scientific;    /**< Whether to print numbers in scientific notation. */
-  char
-      format[MYTOML_MAX_DATE_FORMAT]; /**< Format string for datetime values. */
+  union
+  {
+    int64_t integer;         /**< Value of a TOML_INT. */
+    double number;           /**< Value of a TOML_FLOAT. */
+    bool boolean;            /**< Value of a TOML_BOOL. */
+    TomlDatetime datetime;   /**< Value of the datetime types. */
+    struct TomlKey_t *table; /**< Key holding a TOML_INLINETABLE. */
+    struct
+    {
+      union
+      {
+        TomlValue **arr; /**< Elements of a TOML_ARRAY. */
+        char *str;       /**< `\0` terminated bytes of a TOML_STRING. */
+      };
+      int len; /**< Number of elements or bytes. */
+      int cap; /**< Number of allocated slots in `arr`. */
+    };
+  };
 };
 
 /** @} */
@@ -704,18 +768,109 @@ struct TomlValue_t
  * associated value.
  */
 typedef struct TomlKey_t TomlKey;
-KHASH_MAP_INIT_STR(str, TomlKey *)
+
+/**
+ * @def TOML_KEY_NO_INDEX
+ * @brief `TomlKey::idx` of a key that is not an array of tables.
+ */
+#define TOML_KEY_NO_INDEX SIZE_MAX
+
+/**
+ * @struct TomlEntry
+ * @brief A subkey of a TomlTable along with the hash of its identifier.
+ */
+typedef struct TomlEntry_t
+{
+  uint32_t hash; /**< Hash of `key->id`. */
+  TomlKey *key;  /**< The subkey. */
+} TomlEntry;
+
+/**
+ * @struct TomlTable
+ * @brief Subkeys of a TomlKey.
+ * @details `entry` keeps the subkeys densely in the order they first appear
+ * in the document, so iterating and dumping a table is a linear scan with a
+ * reproducible result. Entries are searched linearly by hash until the table
+ * holds more than `MYTOML_TABLE_INDEX_THRESHOLD` of them, after which `index`
+ * is built alongside them. Keys without subkeys allocate nothing.
+ */
+typedef struct TomlTable_t
+{
+  TomlEntry *entry;          /**< The subkeys, in document order. */
+  int len;                   /**< Number of subkeys. */
+  int cap;                   /**< Number of allocated entries. */
+  void *index;               /**< Hash index of large tables, else NULL. */
+} TomlTable;
+
+/**
+ * @struct TomlKey
+ * @brief A key of a TOML document and its value or subkeys.
+ * @details A key assigned an inline table, like `k` in `k = {a = 1}`, is a
+ * TOML_KEYLEAF whose `value` is NULL and whose `subkeys` hold the members of
+ * the table, exactly like a `[k]` table. Only inline tables inside arrays are
+ * TOML_INLINETABLE values, whose `table` key holds the members.
+ */
 struct TomlKey_t
 {
   TomlKeyType type;              /**< Type of TOML key. */
-  char id[MYTOML_MAX_ID_LENGTH]; /**< Key identifier string. */
-  khash_t(str) * subkeys;        /**< Hash map of subkeys. */
-  TomlValue *value;              /**< Value associated with this key. */
-  size_t idx;                    /**< Index for array tables. */
+  const char *id;                /**< Interned identifier, `\0` terminated. */
+  TomlTable subkeys;             /**< Subkeys of the key. */
+  TomlValue *value;              /**< Value of a key-value pair, NULL for tables and inline tables. */
+  size_t idx;                    /**< Last element of an array of tables, else `TOML_KEY_NO_INDEX`. */
 };
 
 /** @} */
 
+/**
+ * @name TomlPath data type
+ * @{
+ */
+
+/**
+ * @struct TomlPath
+ * @brief Opaque compiled path with every key already hashed.
+ * @details Holds no pointers into a document, so one path can be used with
+ * any number of documents, including ones loaded after it was compiled.
+ * @see toml_path_compile
+ */
+typedef struct TomlPath_t TomlPath;
+
+/** @} */
+
+/**
+ * @name TomlStream data type
+ * @{
+ */
+
+/**
+ * @struct TomlStream
+ * @brief Opaque push parser a document is fed to in pieces.
+ * @details Whole statements are parsed as soon as they are complete, so only
+ * the statement cut by the end of the last piece is kept between feeds.
+ * @see toml_stream_new
+ */
+typedef struct TomlStream_t TomlStream;
+
+/** @} */
+
+/**
+ * @name TomlWriteCallback data type
+ * @{
+ */
+
+/**
+ * @typedef TomlWriteCallback
+ * @brief Sink the streaming dump functions hand their output to.
+ * @param[in] data Bytes to write.
+ * @param[in] size Number of bytes at `data`.
+ * @param[in] user Pointer passed through from the dump call.
+ * @return Number of bytes written. Anything short of `size` stops the dump.
+ * @see toml_key_dump_callback, toml_value_dump_callback
+ */
+typedef size_t (*TomlWriteCallback)(const char *data, size_t size, void *user);
+
+/** @} */
+
 /**
  * @name TomlError data type
  * @{
@@ -766,6 +921,8 @@ extern "C"
    * @brief Load and parse a TOML file from a FILE pointer.
    * @param[in] file FILE pointer to TOML file.
    * @return Pointer to root TomlKey object, or NULL on failure.
+   * @note Streams that cannot be seeked, such as pipes or `stdin`, are read
+   * piece by piece with a TomlStream from their current position.
    * @note Frees memory with toml_free().
    * @see toml_free
    */
@@ -780,6 +937,104 @@ extern "C"
    */
   MYTOML_API TomlKey *toml_loads(const char *toml);
 
+  /**
+   * @brief Parse TOML from a length delimited buffer.
+   * @param[in] buf Buffer holding the TOML document.
+   * @param[in] len Number of bytes in `buf`.
+   * @return Pointer to root TomlKey object, or NULL on failure.
+   * @note `buf` is parsed in place. It is neither copied nor required to be
+   * NUL terminated, and only needs to stay valid for the duration of the call.
+   * @note Frees memory with toml_free().
+   * @see toml_free
+   */
+  MYTOML_API TomlKey *toml_loads_n(const char *buf, size_t len);
+
+  /**
+   * @brief Parse TOML from a length delimited buffer, reporting failures in
+   * `err`.
+   * @param[in] buf Buffer holding the TOML document.
+   * @param[in] len Number of bytes in `buf`.
+   * @param[out] err Filled with the first error met, or `TOML_OK`. May be
+   * NULL.
+   * @return Pointer to root TomlKey object, or NULL on failure.
+   * @note Nothing is written to `stderr`. `err->message` is a static string,
+   * and `err->line` and `err->column` are one based (zero when the error has
+   * no location, e.g. an allocation failure before parsing starts).
+   * @note The parser keeps no global state, so separate documents can be
+   * parsed from many threads at once.
+   * @note Frees memory with toml_free().
+   * @see toml_loads_n
+   * @see toml_free
+   */
+  MYTOML_API TomlKey *toml_parse_ex(const char *buf, size_t len, TomlError_t *err);
+
+  /**
+   * @brief Parse a large TOML document from a length delimited buffer on
+   * several threads.
+   * @param[in] buf Buffer holding the TOML document.
+   * @param[in] len Number of bytes in `buf`.
+   * @param[in] threads Largest number of threads to use, or 0 for one per
+   * online processor.
+   * @param[out] err Filled like toml_parse_ex(). May be NULL.
+   * @return Pointer to root TomlKey object, or NULL on failure.
+   * @details The document is cut into chunks at lines starting with a
+   * `[table]` or `[[array]]` header, the chunks are parsed concurrently and
+   * their tables are merged in document order with the same re-definition
+   * rules as a sequential parse, so the result is the same document.
+   * @note Documents smaller than two `MYTOML_PARALLEL_CHUNK_SIZE` chunks, or
+   * without headers to cut at, are parsed sequentially, as is every document
+   * when the library is built without `MYTOML_USE_THREADS`. When parsing
+   * fails the document is parsed again sequentially to report the error.
+   * @note Frees memory with toml_free().
+   * @see toml_parse_ex
+   * @see toml_free
+   */
+  MYTOML_API TomlKey *toml_parse_parallel(const char *buf, size_t len, int threads, TomlError_t *err);
+
+  /**
+   * @brief Create a push parser for a document that arrives in pieces.
+   * @return Pointer to a TomlStream, or NULL on allocation failure.
+   * @note Frees memory with toml_stream_finish().
+   * Example usage:
+   * @code
+   * TomlStream *stream = toml_stream_new();
+   * while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+   *   if (!toml_stream_feed(stream, chunk, n)) break;
+   * }
+   * TomlKey *toml = toml_stream_finish(stream, &err);
+   * @endcode
+   * @see toml_stream_feed
+   * @see toml_stream_finish
+   */
+  MYTOML_API TomlStream *toml_stream_new(void);
+
+  /**
+   * @brief Feed the next piece of a document to a push parser.
+   * @param[in] stream TomlStream from toml_stream_new().
+   * @param[in] chunk Next bytes of the document.
+   * @param[in] len Number of bytes in `chunk`.
+   * @return true, or false once the document failed to parse.
+   * @details Pieces may be cut anywhere, even inside a token. Complete
+   * statements are parsed straight from `chunk`, which is not kept after the
+   * call; only the statement left incomplete is copied, up to
+   * `MYTOML_MAX_STREAM_CARRY` bytes.
+   * @note The error is reported by toml_stream_finish().
+   * @see toml_stream_finish
+   */
+  MYTOML_API bool toml_stream_feed(TomlStream *stream, const char *chunk, size_t len);
+
+  /**
+   * @brief Parse the rest of a fed document and free the push parser.
+   * @param[in] stream TomlStream from toml_stream_new(). Freed by the call.
+   * @param[out] err Filled like toml_parse_ex(), with lines and columns
+   * counted over the whole document. May be NULL.
+   * @return Pointer to root TomlKey object, or NULL on failure.
+   * @note Frees memory with toml_free().
+   * @see toml_parse_ex
+   * @see toml_free
+   */
+  MYTOML_API TomlKey *toml_stream_finish(TomlStream *stream, TomlError_t *err);
+
   /**
    * @brief Dump TOML key to a FILE stream.
    * @param[in] object TOML key to dump.
@@ -787,15 +1042,18 @@ extern "C"
    * @warning The file must be valid and writable.
    * The caller is responsible for managing the lifetime of the FILE stream if
    * used. Failure to do so may result in resource leaks or crashes.
+   * @return true on success, false if a write failed.
    */
-  MYTOML_API void toml_key_dump_file(TomlKey *object, FILE *file);
+  MYTOML_API bool toml_key_dump_file(TomlKey *object, FILE *file);
 
   /**
    * @brief Dump TOML key to a file by filename.
    * @param[in] object TOML key to dump.
    * @param[in] file Output filename.
+   * @return true on success, false if the file could not be opened or
+   * written.
    */
-  MYTOML_API void toml_key_dump_file_name(TomlKey *object, const char *file);
+  MYTOML_API bool toml_key_dump_file_name(TomlKey *object, const char *file);
 
   /**
    * @brief Dump TOML value to a FILE stream.
@@ -804,20 +1062,68 @@ extern "C"
    * @warning The file must be valid and writable.
    * The caller is responsible for managing the lifetime of the FILE stream if
    * used. Failure to do so may result in resource leaks or crashes.
+   * @return true on success, false if a write failed.
    */
-  MYTOML_API void toml_value_dump_file(TomlValue *object, FILE *file);
+  MYTOML_API bool toml_value_dump_file(TomlValue *object, FILE *file);
 
   /**
    * @brief Dump TOML value to a file by filename.
    * @param[in] object TOML value to dump.
    * @param[in] file Output filename.
+   * @return true on success, false if the file could not be opened or
+   * written.
    */
-  MYTOML_API void toml_value_dump_file_name(TomlValue *object, const char *file);
+  MYTOML_API bool toml_value_dump_file_name(TomlValue *object, const char *file);
+
+  /**
+   * @brief Dump TOML key to a file descriptor.
+   * @param[in] object TOML key to dump.
+   * @param[in] fd Output file descriptor.
+   * @return true on success, false if a write failed.
+   * @note Output goes through a fixed-size staging buffer, so memory use
+   * does not grow with the size of the document.
+   */
+  MYTOML_API bool toml_key_dump_fd(TomlKey *object, int fd);
+
+  /**
+   * @brief Dump TOML value to a file descriptor.
+   * @param[in] object TOML value to dump.
+   * @param[in] fd Output file descriptor.
+   * @return true on success, false if a write failed.
+   * @note Output goes through a fixed-size staging buffer, so memory use
+   * does not grow with the size of the document.
+   */
+  MYTOML_API bool toml_value_dump_fd(TomlValue *object, int fd);
+
+  /**
+   * @brief Dump TOML key through a user callback.
+   * @param[in] object TOML key to dump.
+   * @param[in] write Callback receiving the output one staging buffer at a
+   * time.
+   * @param[in] user Pointer passed to every call of `write`.
+   * @return true on success, false if `write` came up short.
+   * @see TomlWriteCallback
+   */
+  MYTOML_API bool toml_key_dump_callback(TomlKey *object,
+                                         TomlWriteCallback write, void *user);
+
+  /**
+   * @brief Dump TOML value through a user callback.
+   * @param[in] object TOML value to dump.
+   * @param[in] write Callback receiving the output one staging buffer at a
+   * time.
+   * @param[in] user Pointer passed to every call of `write`.
+   * @return true on success, false if `write` came up short.
+   * @see TomlWriteCallback
+   */
+  MYTOML_API bool toml_value_dump_callback(TomlValue *object,
+                                           TomlWriteCallback write, void *user);
 
   /**
    * @brief Serialize TOML key to a string.
    * @param[in] k TOML key to serialize.
-   * @return Pointer to string buffer (must be freed by caller).
+   * @return Pointer to string buffer (must be freed by caller), or NULL if
+   * it could not be allocated.
    * @warning The returned string must be freed by the caller to avoid memory
    * leaks.
    */
@@ -826,7 +1132,8 @@ extern "C"
   /**
    * @brief Serialize TOML value to a string.
    * @param[in] v TOML value to serialize.
-   * @return Pointer to string buffer (must be freed by caller).
+   * @return Pointer to string buffer (must be freed by caller), or NULL if
+   * it could not be allocated.
    * @warning The returned string must be freed by the caller to avoid memory
    * leaks.
    */
@@ -837,6 +1144,8 @@ extern "C"
    * @param[in] k TOML key to dump.
    * @param[out] buffer Pointer to output buffer.
    * @param[out] size Size of output buffer.
+   * @note If the buffer cannot be grown it is freed, and `*buffer` is set to
+   * NULL and `*size` to 0.
    * @warning The buffer must be managed by the caller. The caller is responsible
    * for freeing the buffer to avoid memory leaks.
    */
@@ -847,6 +1156,8 @@ extern "C"
    * @param[in] v TOML value to dump.
    * @param[out] buffer Pointer to output buffer.
    * @param[out] size Size of output buffer.
+   * @note If the buffer cannot be grown it is freed, and `*buffer` is set to
+   * NULL and `*size` to 0.
    * @warning The buffer must be managed by the caller. The caller is responsible
    * for freeing the buffer to avoid memory leaks.     *
    */
@@ -856,12 +1167,81 @@ extern "C"
   /**
    * @brief Dump TOML key as Toml to stdout.
    * @param[in] root Root TOML key to dump as Toml.
+   * @see toml_key_dump_toml_buffer
    */
   MYTOML_API void toml_key_dump(TomlKey *root);
 
+  /**
+   * @brief Dump TOML key as a TOML document to a buffer.
+   * @param[in] root TOML key whose subkeys make up the document.
+   * @param[out] buffer Pointer to output buffer.
+   * @param[out] size Size of output buffer.
+   * @note If the buffer cannot be grown it is freed, and `*buffer` is set to
+   * NULL and `*size` to 0.
+   * @details Pairs come first, dotted keys stay dotted, inline tables stay
+   * inline, and tables and arrays of tables follow as `[table]` and
+   * `[[array-table]]` sections. Floats are written with the fewest digits
+   * that read back as the same value, see `MYTOML_FORMAT_FLOAT`.
+   * @warning The buffer must be managed by the caller. The caller is responsible
+   * for freeing the buffer to avoid memory leaks.
+   */
+  MYTOML_API void toml_key_dump_toml_buffer(TomlKey *root, char **buffer,
+                                            size_t *size);
+
+  /**
+   * @brief Dump TOML key as a TOML document through a user callback.
+   * @param[in] root TOML key whose subkeys make up the document.
+   * @param[in] write Callback receiving the output one staging buffer at a
+   * time.
+   * @param[in] user Pointer passed to every call of `write`.
+   * @return true on success, false if `write` came up short.
+   * @see toml_key_dump_toml_buffer, TomlWriteCallback
+   */
+  MYTOML_API bool toml_key_dump_toml_callback(TomlKey *root,
+                                              TomlWriteCallback write,
+                                              void *user);
+
+  /**
+   * @brief Dump TOML key as plain JSON to stdout.
+   * @param[in] root Root TOML key to dump as JSON.
+   * @see toml_key_dump_json_buffer
+   */
+  MYTOML_API void toml_json_dump(TomlKey *root);
+
+  /**
+   * @brief Dump TOML key as a plain JSON object to a buffer.
+   * @param[in] root TOML key whose subkeys make up the object.
+   * @param[out] buffer Pointer to output buffer.
+   * @param[out] size Size of output buffer.
+   * @note If the buffer cannot be grown it is freed, and `*buffer` is set to
+   * NULL and `*size` to 0.
+   * @details Unlike toml_key_dump_buffer() values are not tagged with their
+   * type, e.g. `{"port": 8080}`. Tables become objects, datetimes strings,
+   * and `inf` and `nan`, which JSON cannot represent, `null`.
+   * @warning The buffer must be managed by the caller. The caller is responsible
+   * for freeing the buffer to avoid memory leaks.
+   */
+  MYTOML_API void toml_key_dump_json_buffer(TomlKey *root, char **buffer,
+                                            size_t *size);
+
+  /**
+   * @brief Dump TOML key as a plain JSON object through a user callback.
+   * @param[in] root TOML key whose subkeys make up the object.
+   * @param[in] write Callback receiving the output one staging buffer at a
+   * time.
+   * @param[in] user Pointer passed to every call of `write`.
+   * @return true on success, false if `write` came up short.
+   * @see toml_key_dump_json_buffer, TomlWriteCallback
+   */
+  MYTOML_API bool toml_key_dump_json_callback(TomlKey *root,
+                                              TomlWriteCallback write,
+                                              void *user);
+
   /**
    * @brief Free memory allocated for a TomlKey object and all its children.
    * @param[in] toml Pointer to TomlKey object to free.
+   * @note A document parsed with `MYTOML_USE_ARENA` is released one arena
+   * chunk at a time instead of one node at a time.
    */
   MYTOML_API void toml_free(TomlKey *toml);
 
@@ -870,7 +1250,7 @@ extern "C"
    * @param[in] key TOML key to query.
    * @return Pointer to integer value, or NULL if not an integer.
    */
-  MYTOML_API int *toml_get_int(TomlKey *key);
+  MYTOML_API int64_t *toml_get_int(TomlKey *key);
 
   /**
    * @brief Get boolean value from TOML key.
@@ -903,9 +1283,26 @@ extern "C"
   /**
    * @brief Get datetime value from TOML key.
    * @param[in] key TOML key to query.
-   * @return Pointer to struct tm value, or NULL if not a datetime.
+   * @return Pointer to datetime fields, or NULL if not a datetime.
    */
-  MYTOML_API struct tm *toml_get_datetime(TomlKey *key);
+  MYTOML_API TomlDatetime *toml_get_datetime(TomlKey *key);
+
+  /**
+   * @brief Get the number of subkeys of a TOML key.
+   * @param[in] key TOML key to query.
+   * @return Number of subkeys, or 0 if `key` is NULL.
+   * @see toml_key_at, toml_key_foreach
+   */
+  MYTOML_API int toml_key_count(const TomlKey *key);
+
+  /**
+   * @brief Get a subkey of a TOML key by position.
+   * @param[in] key TOML key to query.
+   * @param[in] index Position of the subkey in document order.
+   * @return Pointer to the subkey, or NULL if `index` is out of range.
+   * @see toml_key_count, toml_key_foreach
+   */
+  MYTOML_API TomlKey *toml_key_at(const TomlKey *key, int index);
 
   /**
    * @brief Find a subkey by identifier.
@@ -915,6 +1312,44 @@ extern "C"
    */
   MYTOML_API TomlKey *toml_get_key(TomlKey *key, const char *id);
 
+  /**
+   * @brief Find a key by dotted path.
+   * @param[in] root TOML key to start from.
+   * @param[in] path Path such as `server.tls.cert`, `"a.b".'c'` or
+   * `fruit[0].name`.
+   * @return Pointer to matching TomlKey, or NULL if not found.
+   * @details Keys are bare, "basic" or 'literal' keys separated by dots. An
+   * `[index]` after a key selects a table of an array of tables or of an
+   * array of inline tables.
+   * @note Compiles `path` on every call. Use toml_path_compile() for lookups
+   * that repeat.
+   */
+  MYTOML_API TomlKey *toml_get_path(TomlKey *root, const char *path);
+
+  /**
+   * @brief Compile a dotted path for repeated lookups.
+   * @param[in] path Path in the syntax of toml_get_path().
+   * @return Compiled path, or NULL if `path` is invalid.
+   * @note Frees memory with toml_path_free().
+   * @see toml_path_get
+   */
+  MYTOML_API TomlPath *toml_path_compile(const char *path);
+
+  /**
+   * @brief Find a key by compiled path.
+   * @param[in] root TOML key to start from.
+   * @param[in] path Path compiled with toml_path_compile().
+   * @return Pointer to matching TomlKey, or NULL if not found.
+   * @note No key of `path` is hashed again.
+   */
+  MYTOML_API TomlKey *toml_path_get(TomlKey *root, const TomlPath *path);
+
+  /**
+   * @brief Free a compiled path.
+   * @param[in] path Path to free.
+   */
+  MYTOML_API void toml_path_free(TomlPath *path);
+
   /** @} */
 
 #ifdef __cplusplus
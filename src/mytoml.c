@@ -52,15 +52,124 @@
 // [SECTION] INCLUDES
 //-------------------------------------------------------------------------
 
+// keep POSIX declarations such as `posix_madvise` visible in strict ISO C modes
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <mytoml/mytoml.h>
 
 #include <math.h>     //
 #include <stdarg.h>   //
 #include <stdbool.h>  //
+#include <stddef.h>   // for offsetof
+#include <float.h>    // for FLT_EVAL_METHOD
+#include <stdint.h>   // for uint64_t
 #include <stdio.h>    // for printf
 #include <stdlib.h>   // for realloc
 #include <string.h>   // for strdup strlen
-#include <time.h>     //
+
+/**
+ * @def MYTOML_USE_MMAP
+ * @brief Load files opened by name through `mmap` instead of copying them
+ * into a heap buffer.
+ * @note Defaults to 1 on Linux and Apple platforms, 0 elsewhere.
+ */
+#ifndef MYTOML_USE_MMAP
+#if MYTOML_PLATFORM_IS(LINUX) || MYTOML_PLATFORM_IS(APPLE)
+#define MYTOML_USE_MMAP 1
+#else
+#define MYTOML_USE_MMAP 0
+#endif
+#endif  // MYTOML_USE_MMAP
+
+#if MYTOML_USE_MMAP
+#include <fcntl.h>     // for open
+#include <sys/mman.h>  // for mmap posix_madvise munmap
+#include <sys/stat.h>  // for fstat
+#endif  // MYTOML_USE_MMAP
+
+#if MYTOML_PLATFORM_IS(WINDOWS)
+#include <io.h>  // for _write
+#else
+#include <unistd.h>  // for close write
+#endif
+
+/**
+ * @def MYTOML_USE_SIMD
+ * @brief Scan whitespace, comments and string bodies 16 or 32 bytes at a
+ * time instead of one byte at a time.
+ * @note Uses AVX2, SSE2 or NEON when the compiler targets them and a
+ * scalar loop otherwise. Define to 0 to always use the scalar loop.
+ */
+#ifndef MYTOML_USE_SIMD
+#define MYTOML_USE_SIMD 1
+#endif  // MYTOML_USE_SIMD
+
+#if MYTOML_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>  // for _mm_movemask_epi8
+#define MYTOML_SIMD_SSE2 1
+#if defined(__AVX2__)
+#include <immintrin.h>  // for _mm256_movemask_epi8
+#define MYTOML_SIMD_AVX2 1
+#endif
+#if MYTOML_COMPILER_IS(MSVC)
+#include <intrin.h>  // for _BitScanForward
+#endif
+#elif MYTOML_USE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !MYTOML_COMPILER_IS(MSVC)
+#include <arm_neon.h>  // for vld1q_u8
+#define MYTOML_SIMD_NEON 1
+#endif
+
+/**
+ * @def MYTOML_USE_ARENA
+ * @brief Allocate every key, value, string and array of a parsed document
+ * from a bump-pointer arena owned by the root key.
+ * @note Defaults to 0. `toml_free` then releases the document one chunk at
+ * a time instead of walking it node by node.
+ */
+#ifndef MYTOML_USE_ARENA
+#define MYTOML_USE_ARENA 0
+#endif  // MYTOML_USE_ARENA
+
+/**
+ * @def MYTOML_ARENA_CHUNK_SIZE
+ * @brief Size in bytes of the blocks an arena requests from `malloc`.
+ * @note Default is 65536 [`2^16`]. Larger allocations get a block of their
+ * own.
+ */
+#ifndef MYTOML_ARENA_CHUNK_SIZE
+#define MYTOML_ARENA_CHUNK_SIZE 65536
+#endif  // MYTOML_ARENA_CHUNK_SIZE
+
+/**
+ * @def MYTOML_USE_THREADS
+ * @brief Let `toml_parse_parallel` parse large documents on several POSIX
+ * threads.
+ * @note Defaults to 1 on Linux and Apple platforms, 0 elsewhere, where
+ * `toml_parse_parallel` always parses sequentially.
+ */
+#ifndef MYTOML_USE_THREADS
+#if MYTOML_PLATFORM_IS(LINUX) || MYTOML_PLATFORM_IS(APPLE)
+#define MYTOML_USE_THREADS 1
+#else
+#define MYTOML_USE_THREADS 0
+#endif
+#endif  // MYTOML_USE_THREADS
+
+#if MYTOML_USE_THREADS
+#include <pthread.h>  // for pthread_create pthread_join
+#endif  // MYTOML_USE_THREADS
+
+/**
+ * @def MYTOML_PARALLEL_CHUNK_SIZE
+ * @brief Smallest number of bytes `toml_parse_parallel` hands to a thread.
+ * @note Default is 1048576 [`2^20`]. Documents smaller than two chunks are
+ * parsed sequentially.
+ */
+#ifndef MYTOML_PARALLEL_CHUNK_SIZE
+#define MYTOML_PARALLEL_CHUNK_SIZE 1048576
+#endif  // MYTOML_PARALLEL_CHUNK_SIZE
 
 #pragma region Internal
 
@@ -69,30 +178,37 @@
 //-----------------------------------------------------------------------------
 
 /**
- * @def LOG_ERR
- * @brief Macro to log error message to stderr.
- * @note It also specifies which file, line and function the error was raised
- * in.
+ * @def MYTOML_WRITER_INITIAL_CAPACITY
+ * @brief Number of bytes a writer allocates for its first write.
+ * @note Default is 256 [`2^8`]. Writers double their capacity when full.
  */
-#define LOG_ERR(...)                                                   \
-    do {                                                               \
-        fprintf(stderr, "%s:%d [%s]: ", __FILE__, __LINE__, __func__); \
-        fprintf(stderr, __VA_ARGS__);                                  \
-    } while (0)
+#define MYTOML_WRITER_INITIAL_CAPACITY 256
 
 /**
- * @def RETURN_IF_FAILED
- * @brief Macro to check `COND` and return if it fails.
- * @param COND expression to check.
- * @note returns NULL from the location where it is called.
+ * @def MYTOML_WRITER_STAGING_SIZE
+ * @brief Size of the buffer a writer fills before handing it to its sink.
+ * @note Default is 16384 [`2^14`].
  */
-#define RETURN_IF_FAILED(COND, ...) \
-    do {                            \
-        if (!(COND)) {              \
-            LOG_ERR(__VA_ARGS__);   \
-            return NULL;            \
-        }                           \
-    } while (0)
+#define MYTOML_WRITER_STAGING_SIZE 16384
+
+/**
+ * @def MYTOML_FORMAT_FLOAT
+ * @brief Formatter the dump functions use to write finite doubles.
+ * @note Called as `MYTOML_FORMAT_FLOAT(value, buffer)`. It must write at most
+ * 32 characters that read back as exactly `value` to `buffer` and return how
+ * many it wrote. Defaults to a built-in Grisu2 formatter; define it to plug
+ * in another shortest round-trip formatter such as Ryu.
+ */
+#ifndef MYTOML_FORMAT_FLOAT
+#define MYTOML_FORMAT_FLOAT(value, buffer) _mytoml_format_float((value), (buffer))
+#endif  // MYTOML_FORMAT_FLOAT
+
+/**
+ * @def WRITE_LITERAL
+ * @brief Macro to append the string literal `S` to the writer `W`.
+ * @note The length is known at compile time, so no `strlen` is needed.
+ */
+#define WRITE_LITERAL(W, S) _mytoml_writer_write((W), (S), sizeof(S) - 1)
 
 /**
  * @def FUNC_IF_FAILED
@@ -109,52 +225,92 @@
     } while (0)
 
 /**
- * @def CHECK_DATETIME
- * @brief Macro to check date and time.
- * @param VAR variable to check.
- * @param LEN expected variable lenght.
+ * @def PARSE_ERR
+ * @brief Macro to record a parse error in the tokenizer `TOK`.
+ * @note Only the first error is kept, and nothing is written to stderr.
+ */
+#define PARSE_ERR(TOK, TYPE, MESSAGE) _mytoml_parser_error((TOK), (TYPE), (MESSAGE))
+
+/**
+ * @def PARSE_IF_FAILED
+ * @brief Macro to check `COND` and record a parse error if it fails.
+ * @param TOK tokenizer to record the error in.
+ * @param COND expression to check.
+ * @param TYPE `TomlErrorType` of the error.
+ * @param MESSAGE static string describing the error.
  * @note returns NULL from the location where it is called.
  */
-#define CHECK_DATETIME(VAR, LEN, ...)                      \
-    do {                                                   \
-        RETURN_IF_FAILED(strlen(VAR) == LEN, __VA_ARGS__); \
-        num = strtoul(VAR, &end, 10);                      \
-        RETURN_IF_FAILED(end == VAR + LEN, __VA_ARGS__);   \
+#define PARSE_IF_FAILED(TOK, COND, TYPE, MESSAGE) \
+    do {                                          \
+        if (!(COND)) {                            \
+            PARSE_ERR(TOK, TYPE, MESSAGE);        \
+            return NULL;                          \
+        }                                         \
     } while (0)
 
+//-----------------------------------------------------------------------------
+// [SECTION] Data Structures
+//-----------------------------------------------------------------------------
+
 /**
- * @def CHECK_DATE
- * @brief Macro to check date.
- * @note This macro is used in check/validate year, month and day.
+ * @name Identifier data types
+ * @{
  */
-#define CHECK_DATE()                               \
-    do {                                           \
-        CHECK_DATETIME(year, 4, "invalid year\n"); \
-        time->tm_year = num - 1900;                \
-        CHECK_DATETIME(mon, 2, "invalid month\n"); \
-        time->tm_mon = num - 1;                    \
-        CHECK_DATETIME(mday, 2, "invalid day\n");  \
-        time->tm_mday = num;                       \
-    } while (0)
 
 /**
- * @def CHECK_TIME
- * @brief Macro to check time.
- * @note This macro is used in check/validate hour, minute and seconds.
+ * @struct InternedId
+ * @brief Length and hash stored in front of every interned identifier.
+ * @note `TomlKey::id` points at `bytes`, see `ID_HEADER`.
  */
-#define CHECK_TIME()                                \
-    do {                                            \
-        CHECK_DATETIME(hour, 2, "invalid hour\n");  \
-        time->tm_hour = num;                        \
-        CHECK_DATETIME(min, 2, "invalid minute\n"); \
-        time->tm_min = num;                         \
-        CHECK_DATETIME(sec, 2, "invalid second\n"); \
-        time->tm_sec = num;                         \
-    } while (0)
+typedef struct InternedId {
+    uint32_t hash;   /**< Hash of the identifier */
+    uint32_t length; /**< Number of bytes before the terminating `\0` */
+    char bytes[];    /**< The identifier */
+} InternedId;
 
-//-----------------------------------------------------------------------------
-// [SECTION] Data Structures
-//-----------------------------------------------------------------------------
+#define ID_HEADER(id) ((const InternedId *)((id) - offsetof(InternedId, bytes)))
+#define ID_HASH(id) (ID_HEADER(id)->hash)
+#define ID_LENGTH(id) (ID_HEADER(id)->length)
+
+/**
+ * @struct IdSpan
+ * @brief Identifier bytes along with their hash, used as a khash key.
+ * @note Lets identifiers be searched by bytes that were never interned, such
+ * as a key in the input or of a compiled path.
+ */
+typedef struct IdSpan {
+    const char *bytes; /**< The identifier, not necessarily `\0` terminated */
+    uint32_t length;   /**< Number of bytes at `bytes` */
+    khint_t hash;      /**< Hash of the bytes, see `_mytoml_hash` */
+} IdSpan;
+
+#define _mytoml_span_hash(s) ((s).hash)
+#define _mytoml_span_equal(a, b) \
+    ((a).hash == (b).hash && (a).length == (b).length && ((a).bytes == (b).bytes || memcmp((a).bytes, (b).bytes, (a).length) == 0))
+
+// interned identifiers of a document
+KHASH_INIT(id, IdSpan, char, 0, _mytoml_span_hash, _mytoml_span_equal)
+
+// hash index of a large TomlTable, its subkeys keyed by `id`
+KHASH_INIT(index, IdSpan, TomlKey *, 1, _mytoml_span_hash, _mytoml_span_equal)
+
+/**
+ * @struct TomlArena
+ * @brief Bump-pointer arena a whole document can be allocated from.
+ * @see MYTOML_USE_ARENA
+ */
+typedef struct TomlArena TomlArena;
+
+/**
+ * @struct InternPool
+ * @brief Identifiers interned while parsing a document.
+ */
+typedef struct InternPool {
+    TomlArena *arena; /**< Arena the identifiers are allocated from */
+    khash_t(id) *ids; /**< Identifiers interned so far */
+} InternPool;
+
+/** @} */
 
 /**
  * @defgroup Parser Basis Types
@@ -165,12 +321,11 @@
 /*
     Struct `tokenizer` handles the input stream
     by reading and returning tokens for the parser.
-    However, this currently returns each character
-    as a token. It allows each state of the parser
-    to determine if it is an acceptable token, and
-    stop parsing as soon as it is not.
-
-    TODO: Refactor to parse tokens instead of characters
+    The lexer emits whole tokens (keys, strings,
+    numbers, datetimes, punctuation and comments)
+    as offset/length spans into the input buffer.
+    String values are decoded from their span into
+    a buffer sized from the token.
 */
 
 /**
@@ -203,11 +358,57 @@ typedef struct Input {
         FILE *pointer;    /**< The `FILE*` file input pointer. */
     } file;
 
-    char *stream; /**< Pointer for storing the input buffer */
+    const char *stream; /**< Pointer to the input buffer */
+    size_t size;        /**< Number of bytes in `stream` */
+    bool owned;         /**< Whether `stream` was allocated by the tokenizer */
+    bool mapped;        /**< Whether `stream` is a read-only file mapping */
 } Input;
 
 /** @} */
 
+/**
+ * @name Parser Token type
+ * @{
+ */
+
+/**
+ * @enum TokenType
+ * @brief Enumerates all tokens emitted by the lexer.
+ */
+typedef enum TokenType {
+    T_EOF,               /**< End of the input */
+    T_INVALID,           /**< Input that cannot start or finish a token */
+    T_NEWLINE,           /**< `\n` or `\r\n` */
+    T_WHITESPACE,        /**< A run of spaces and tabs */
+    T_COMMENT,           /**< `#` up to the end of the line */
+    T_BARE,              /**< Bare key, number, boolean or datetime */
+    T_BASIC_STRING,      /**< `"..."` */
+    T_LITERAL_STRING,    /**< `'...'` */
+    T_ML_BASIC_STRING,   /**< `"""..."""` */
+    T_ML_LITERAL_STRING, /**< `'''...'''` */
+    T_DOT,               /**< `.` */
+    T_EQUAL,             /**< `=` */
+    T_COMMA,             /**< `,` */
+    T_LBRACKET,          /**< `[` */
+    T_RBRACKET,          /**< `]` */
+    T_DLBRACKET,         /**< `[[`, only emitted for keys */
+    T_DRBRACKET,         /**< `]]`, only emitted for keys */
+    T_LBRACE,            /**< `{` */
+    T_RBRACE             /**< `}` */
+} TokenType;
+
+/**
+ * @struct Token
+ * @brief Represents a span of the input buffer.
+ */
+typedef struct Token {
+    TokenType type; /**< The kind of token */
+    int offset;     /**< Offset of the first byte in the input buffer */
+    int length;     /**< Number of bytes in the token */
+} Token;
+
+/** @} */
+
 /**
  * @name Parser Input type
  * @{
@@ -219,20 +420,72 @@ typedef struct Input {
  */
 typedef struct Tokenizer {
     Input input;
-    int cursor;                      /**< The location in the input buffer */
-    char token;                      /**< The last read in token */
-    char prev;                       /**< The token read in before `token` */
-    char prev_prev;                  /**< The token read in before `prev` */
-    bool is_null;                    /**< Boolean to indicate if `token` is non-NULL */
-    bool newline;                    /**< To keep track if we are on a newline */
-    int line;                        /**< The current line number in the stream */
-    int col;                         /**< The current column number in the stream */
-    int lines[MYTOML_MAX_NUM_LINES]; /**, The array where index=line and
-                                        lines[index]=length */
+    Token current;     /**< The token last emitted by the lexer */
+    int cursor;        /**< The location in the input buffer */
+    char token;        /**< The last read in character */
+    bool is_null;      /**< Boolean to indicate if `token` is non-NULL */
+    TomlArena *arena;  /**< Arena to allocate the document from, or NULL */
+    InternPool pool;   /**< Identifiers of the document */
+    TomlError_t error; /**< The first error met, `TOML_OK` if none */
+    int error_offset;  /**< Offset of the token the error was met at */
+    int *continued;    /**< Arrays of tables continued from an earlier chunk, or NULL */
 } Tokenizer;
 
 /** @} */
 
+#if MYTOML_USE_THREADS
+
+/**
+ * @name Parallel parsing type
+ * @{
+ */
+
+/**
+ * @struct ParseJob
+ * @brief A chunk of a document parsed on its own thread.
+ */
+typedef struct ParseJob {
+    const char *stream; /**< First byte of the chunk */
+    size_t size;        /**< Number of bytes in the chunk */
+    TomlKey *root;      /**< The parsed chunk, NULL on failure */
+    bool first;         /**< Whether the chunk starts the document */
+    int continued;      /**< Arrays of tables the chunk continues */
+    pthread_t thread;   /**< The thread parsing the chunk */
+    bool started;       /**< Whether `thread` was created */
+} ParseJob;
+
+/** @} */
+
+#endif  // MYTOML_USE_THREADS
+
+/**
+ * @name Streaming parser type
+ * @{
+ */
+
+/**
+ * A document fed in pieces is parsed one batch of whole
+ * statements at a time by the same tokenizer, while the
+ * statement cut by the end of a piece waits in `carry`.
+ * `scanned` bytes of it are known to be complete lines, and
+ * `depth` and `quote` give the state at their end.
+ */
+struct TomlStream_t {
+    Tokenizer *tok;  /**< Tokenizer holding the arena, identifiers and error */
+    TomlKey *root;   /**< The document, NULL once it failed */
+    TomlKey *table;  /**< The table key-values are added to */
+    char *carry;     /**< The statement not complete yet */
+    size_t len;      /**< Number of bytes in `carry` */
+    size_t cap;      /**< Capacity of `carry` */
+    size_t scanned;  /**< Bytes of `carry` holding complete lines */
+    int lines;       /**< Number of complete lines in `carry` */
+    int depth;       /**< Brackets open at the end of `scanned` */
+    char quote;      /**< Multi-line string open at the end of `scanned`, or 0 */
+    int line;        /**< Lines of the document parsed so far */
+};
+
+/** @} */
+
 /**
  * @name Number data type
  * @{
@@ -250,8 +503,23 @@ typedef struct Number {
     TomlValueType type; /**< */
     int precision;      /**<  */
     bool scientific;    /**<  */
+    int64_t integer;    /**< The value of a TOML_INT */
+    double number;      /**< The value of a TOML_FLOAT */
 } Number;
 
+/**
+ * @struct Decimal
+ * @brief Represent the significant digits of a float being parsed.
+ * @note The float is `mantissa * 10^exponent` unless digits past the 19th
+ * were dropped, which sets `truncated`.
+ */
+typedef struct Decimal {
+    uint64_t mantissa; /**< The first 19 significant digits */
+    int digits;        /**< Number of digits in `mantissa` */
+    int exponent;      /**< Power of ten to scale `mantissa` by */
+    bool truncated;    /**< Whether non-zero digits were dropped */
+} Decimal;
+
 /** @} */
 
 /**
@@ -262,19 +530,149 @@ typedef struct Number {
 /**
  * @struct Datetime
  * @brief Represent a generic type for a parsed datetime values.
- * number can be either integer or floating-point.
- * It also stores the matching format, again for compliance testing.
+ * It also stores the number of fraction digits, again for compliance testing.
  * @note Used for DATETIME, DATELOCAL, TIMELOCAL and DATETIMELOCAL value types.
  */
 typedef struct Datetime {
-    struct tm *dt;                       /**  */
-    TomlValueType type;                  /**  */
-    char format[MYTOML_MAX_DATE_FORMAT]; /**  */
-    int millis;                          /**  */
+    TomlDatetime value; /**< The packed datetime fields */
+    TomlValueType type; /**< The kind of datetime that was parsed */
+    int precision;      /**< Number of fraction digits of the seconds */
 } Datetime;
 
 /** @} */
 
+/**
+ * @name Writer data type
+ * @{
+ */
+
+/**
+ * @struct Writer
+ * @brief Output buffer the dump functions write into.
+ * @note Without a sink `data` grows to hold the whole output. With one it is
+ * a fixed staging buffer that is flushed to the sink whenever it fills up.
+ * One byte past `len` is always reserved for the terminating `\0`.
+ */
+typedef struct Writer {
+    char *data;             /**< The output buffer */
+    size_t len;             /**< Number of bytes written to `data` */
+    size_t cap;             /**< Number of bytes allocated for `data` */
+    size_t flushed;         /**< Number of bytes already handed to `sink` */
+    TomlWriteCallback sink; /**< Where full buffers go, NULL to grow */
+    void *user;             /**< User data passed to `sink` */
+    bool failed;            /**< Whether growing or flushing `data` failed */
+} Writer;
+
+/**
+ * @struct KeyPath
+ * @brief Link in the chain of keys leading to a table or a dotted key.
+ * @note Links live on the C stack of the emitter, so writing a path never
+ * allocates.
+ */
+typedef struct KeyPath {
+    const struct KeyPath *parent; /**< Path of the enclosing key, NULL at the top */
+    const TomlKey *key;           /**< Last key of the path */
+} KeyPath;
+
+/** @} */
+
+/**
+ * @name Path data types
+ * @{
+ */
+
+/**
+ * @struct PathSegment
+ * @brief One step of a compiled path: a key or an array index.
+ */
+typedef struct PathSegment {
+    const char *id; /**< `\0` terminated key, NULL for an array index */
+    size_t length;  /**< Number of bytes in `id` */
+    khint_t hash;   /**< Hash of `id` */
+    size_t index;   /**< Array index when `id` is NULL */
+} PathSegment;
+
+struct TomlPath_t {
+    int len;                /**< Number of segments */
+    PathSegment segment[];  /**< Segments, followed by their keys */
+};
+
+/** @} */
+
+/**
+ * @name Number formatting data types
+ * @{
+ */
+
+/**
+ * @struct DiyFp
+ * @brief Floating-point number `f * 2^e` with a 64-bit significand.
+ */
+typedef struct DiyFp {
+    uint64_t f; /**< Significand */
+    int e;      /**< Binary exponent */
+} DiyFp;
+
+/**
+ * @struct CachedPower
+ * @brief Normalized approximation `f * 2^e` of `10^k`.
+ */
+typedef struct CachedPower {
+    uint64_t f; /**< Significand */
+    int e;      /**< Binary exponent */
+    int k;      /**< Decimal exponent */
+} CachedPower;
+
+/** @} */
+
+/**
+ * @name Arena data type
+ * @{
+ */
+
+/**
+ * @struct ArenaChunk
+ * @brief A block of memory an arena hands out allocations from.
+ * @note The usable bytes follow the header, aligned to 16 bytes.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *next; /**< The previously filled chunk */
+    size_t size;             /**< Number of usable bytes in the chunk */
+    size_t used;             /**< Number of bytes handed out so far */
+    size_t last;             /**< Offset of the last allocation */
+} ArenaChunk;
+
+/**
+ * @struct TomlArena
+ * @brief Owns every allocation made for a document in `MYTOML_USE_ARENA`
+ * mode. The hash indexes of large tables are still allocated by `khash`,
+ * so they are tracked here to be destroyed along with the chunks.
+ */
+struct TomlArena {
+    ArenaChunk *chunk;        /**< The chunk allocations are made from */
+    khash_t(index) **tables;  /**< Hash indexes created for the document */
+    int len;                  /**< Number of tracked hash indexes */
+    int cap;                  /**< Capacity of `tables` */
+    struct TomlArena *next;   /**< Arenas adopted from other documents */
+};
+
+/**
+ * @struct TomlDocument
+ * @brief The root key of a parsed document along with what only the root
+ * owns.
+ * @note `root` comes first, so the root key handed to the caller is also
+ * the document, see `DOCUMENT_OF`, and freeing the root frees both.
+ */
+typedef struct TomlDocument {
+    TomlKey root;     /**< The root key */
+    TomlArena *arena; /**< Arena owning the document, or NULL */
+    TomlArena *ids;   /**< Arena owning the identifiers when `arena` is NULL */
+} TomlDocument;
+
+#define DOCUMENT_OF(root) ((TomlDocument *)(root))
+
+/** @} */
+
 /** @} */
 
 //-----------------------------------------------------------------------------
@@ -289,10 +687,118 @@ extern "C" {
 // [SECTION] Declarations
 //-----------------------------------------------------------------------------
 
-// Helper function to append formatted text to a string buffer
-void _mytoml_append_to_buffer(char **buffer, size_t *size, const char *format, ...);
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Writer
+//-----------------------------------------------------------------------------
+
+/*
+    Function `_mytoml_writer_flush` hands the bytes buffered
+    in `w` to its sink and empties the buffer. Returns false
+    and marks `w` as failed if the sink came up short.
+*/
+bool _mytoml_writer_flush(Writer *w);
+
+/*
+    Function `_mytoml_writer_grow` makes room for `n` more
+    bytes in `w`, doubling its capacity as many times as
+    needed. A writer with a sink is flushed instead and only
+    has room if `n` fits its staging buffer. Returns false
+    if there is still no room.
+*/
+bool _mytoml_writer_grow(Writer *w, size_t n);
+
+/*
+    Function `_mytoml_writer_take` terminates the output of a
+    writer without a sink and hands it over through `buffer`
+    and `size`. If growing the output failed, the output is
+    freed and `buffer` is set to NULL.
+*/
+void _mytoml_writer_take(Writer *w, char **buffer, size_t *size);
+
+/*
+    Function `_mytoml_writer_write` appends the `n` bytes at
+    `s` to `w` with a single `memcpy`.
+*/
+static inline void _mytoml_writer_write(Writer *w, const char *s, size_t n);
+
+/*
+    Function `_mytoml_writer_format` appends formatted text to
+    `w`. It formats straight into the free space of `w` and
+    only formats again if that space was too small.
+*/
+void _mytoml_writer_format(Writer *w, const char *format, ...);
+
+/*
+    Function `_mytoml_writer_escape` appends the `n` bytes at
+    `s` to `w` as the body of a JSON or TOML basic string. Runs
+    of bytes that need no escaping are copied in bulk.
+*/
+void _mytoml_writer_escape(Writer *w, const char *s, size_t n);
+
+/*
+    Function `_mytoml_format_integer` writes `value` in decimal
+    to `buffer`, two digits at a time, and returns the number
+    of characters written. `buffer` must hold 20 characters.
+*/
+int _mytoml_format_integer(int64_t value, char *buffer);
+
+/*
+    Function `_mytoml_format_float` writes the shortest decimal
+    that reads back as the finite double `value` to `buffer`,
+    using Grisu2, and returns the number of characters written.
+    `buffer` must hold 32 characters.
+*/
+int _mytoml_format_float(double value, char *buffer);
+
+/*
+    Function `_mytoml_writer_integer` appends `value` to `w`.
+*/
+static inline void _mytoml_writer_integer(Writer *w, int64_t value);
+
+/*
+    Function `_mytoml_writer_float` appends the finite double
+    `value` to `w` with `MYTOML_FORMAT_FLOAT`, adding `.0` when
+    the result would otherwise read as an integer.
+*/
+static inline void _mytoml_writer_float(Writer *w, double value);
+
+// Helper function to append a datetime value in RFC 3339 format,
+// with at least `min_precision` fraction digits
+static inline void _mytoml_datetime_dump(Writer *w, const TomlValue *v, int min_precision);
+
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Path
+//-----------------------------------------------------------------------------
+
+/*
+    Function `_mytoml_path_parse` splits `path` into bare,
+    "basic" or 'literal' keys separated by dots, each
+    optionally followed by `[index]` steps. With `segment` and
+    `ids` NULL it only counts the segments; otherwise it also
+    fills `segment` and copies the unescaped keys into `ids`.
+    Returns the number of segments, or -1 if `path` is not a
+    valid path.
+*/
+int _mytoml_path_parse(const char *path, PathSegment *segment, char *ids);
+
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Intern
+//-----------------------------------------------------------------------------
+
+/*
+    Function `_mytoml_hash` hashes the `n` bytes at `s`. For
+    strings without a `\0` it matches `kh_str_hash_func`.
+*/
+static inline khint_t _mytoml_hash(const char *s, size_t n);
 
-static inline void _mytoml_string_dump(const char *s, char **buffer, size_t *size);
+/*
+    Function `_mytoml_intern` returns the identifier of `pool`
+    equal to the `n` bytes at `s`, adding a copy of them
+    behind an `InternedId` header on first use. Every key of a
+    document named `name` thus shares one `name`. Returns NULL
+    on allocation failure.
+*/
+const char *_mytoml_intern(InternPool *pool, const char *s, size_t n);
 
 //-----------------------------------------------------------------------------
 // [SECTION] Myjson Tokenizer
@@ -316,15 +822,19 @@ Tokenizer *_mytoml_new_tokenizer(Input input);
     Function `_mytoml_tokenizer_load_input` loads the data from an the input
     stream onto a char buffer. It also checks to make sure
     that the input is not too large. Upon any error, it
-    returns false and returns true if everything succeeds.
+    records it in `tok` and returns false, and returns true
+    if everything succeeds.
+    `I_STREAM` inputs are used in place and never copied.
+    With `MYTOML_USE_MMAP`, `I_File` inputs are mapped
+    read-only and parsed directly out of the page cache.
 */
 bool _mytoml_tokenizer_load_input(Tokenizer *tok);
 
 /*
     Function `_mytoml_tokenizer_next_token` reads the next character from the
     input stream. It then stores it in the `token` attribute.
-    If we have reached the EOF, the `_mytoml_tokenizer_has_token` attribute is
-    set to false. This also updates all the attributes of the
+    If we have reached the end of the input (`cursor == size`), the
+    `_mytoml_tokenizer_has_token` attribute is set to false. This also updates all the attributes of the
     tokenizer appropriately (except `stream`). If we read in
     a token, i.e. we have not reached EOF, returns 1, else
     returns 0.
@@ -332,19 +842,51 @@ bool _mytoml_tokenizer_load_input(Tokenizer *tok);
 int _mytoml_tokenizer_next_token(Tokenizer *tok);
 
 /*
-    Function `_mytoml_tokenizer_backtrace` is used to move the `cursor` back in
-    the input stream. This allows look-ahead operations to make
-    parsing decisions. For example, let's say we want to decide
-    whether to parse something as a date or a number. To know if
-    there is a `-` a few chars ahead, we call `_mytoml_tokenizer_next_token`.
-    However, in the case that there isn't, we need to go back
-    to where we were and re-parse it as a number. This function
-    takes an argument `count` and backtracks that many characters.
-    To maintain the values of `prev` and `prev_prev`, this goes
-    back 2 extra characters and calls `_mytoml_tokenizer_next_token` twice to
-    re-populate them.
+    Function `_mytoml_tokenizer_peek` returns the character `n`
+    places after `token` without consuming anything, or `\0`
+    past the end of the input. This allows look-ahead operations
+    to make parsing decisions, such as telling a CRLF from a lone
+    carriage return or a closing `"""` from a single quote,
+    without ever moving the `cursor` back.
+*/
+char _mytoml_tokenizer_peek(Tokenizer *tok, int n);
+
+/*
+    Function `_mytoml_tokenizer_seek` moves the `cursor` to `pos`
+    and reads the character found there, so the character based
+    functions can pick up in the middle of a token.
+*/
+void _mytoml_tokenizer_seek(Tokenizer *tok, int pos);
+
+/*
+    Function `_mytoml_lexer_next` scans the token starting at
+    `cursor`, stores its span in `current` and moves `cursor`
+    past it. For keys (`value` false) bare tokens are limited
+    to bare key characters and `[[`/`]]` are single tokens.
+    For values, bare tokens also take `+`, `.` and `:` so
+    numbers and datetimes are scanned whole, as is the space
+    between a date and a time. Returns the token type.
+*/
+TokenType _mytoml_lexer_next(Tokenizer *tok, bool value);
+
+/*
+    Function `_mytoml_tokenizer_location` computes the line and
+    column of `offset` in the input. Nothing is tracked while
+    parsing; instead the input is scanned up to the offset on
+    demand, which is only needed when reporting an error.
+    Both `line` and `col` are zero based.
+*/
+void _mytoml_tokenizer_location(Tokenizer *tok, int offset, int *line, int *col);
+
+/*
+    Function `_mytoml_parser_error` records an error of `type`
+    at the `current` token of `tok`. `message` must be a static
+    string. Since a failure is passed up through every caller,
+    only the first, innermost error is kept. The error is not
+    printed; the line and column are only computed once parsing
+    has stopped.
 */
-void _mytoml_tokenizer_backtrace(Tokenizer *tok, int count);
+void _mytoml_parser_error(Tokenizer *tok, TomlErrorType type, const char *message);
 
 /*
     Function `_mytoml_tokenizer_has_token` returns true if the boolean attribute
@@ -354,19 +896,12 @@ void _mytoml_tokenizer_backtrace(Tokenizer *tok, int count);
 bool _mytoml_tokenizer_has_token(Tokenizer *tok);
 
 /*
-    Functions `_mytoml_tokenizer_get_token`,
-   `_mytoml_tokenizer_get_previous_token` and
-   `_mytoml_tokenizer_get_prev_prev_token` returns the `token`, `prev` and
-   `prev_prev` attributes held by the tokenizer, respectively. This should be
-    used by callers to access the tokens read in by the
-    tokenizer.
+    Function `_mytoml_tokenizer_get_token` returns the `token`
+    attribute held by the tokenizer. This should be used by
+    callers to access the character read in by the tokenizer.
 */
 char _mytoml_tokenizer_get_token(Tokenizer *tok);
 
-char _mytoml_tokenizer_get_previous_token(Tokenizer *tok);
-
-char _mytoml_tokenizer_get_prev_prev_token(Tokenizer *tok);
-
 /**
  * @brief Free any memory allocated for a `tokenizer` object.
  *
@@ -374,47 +909,114 @@ char _mytoml_tokenizer_get_prev_prev_token(Tokenizer *tok);
  */
 void _mytoml_tokenizer_delete(Tokenizer *tok);
 
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Arena
+//-----------------------------------------------------------------------------
+
+/*
+    Function `_mytoml_arena_new` allocates an empty arena.
+    Chunks of `MYTOML_ARENA_CHUNK_SIZE` bytes are requested
+    from `malloc` as allocations are made.
+*/
+TomlArena *_mytoml_arena_new(void);
+
+/*
+    Function `_mytoml_arena_delete` destroys the hash tables
+    tracked by `arena` and frees all of its chunks.
+*/
+void _mytoml_arena_delete(TomlArena *arena);
+
+/*
+    Function `_mytoml_arena_adopt` makes `arena` the owner of
+    `other`, which is then deleted along with it. Nothing is
+    copied, so pointers into `other` stay valid. It is used to
+    keep the memory of a merged document alive.
+*/
+void _mytoml_arena_adopt(TomlArena *arena, TomlArena *other);
+
+/*
+    Function `_mytoml_arena_track` records the hash index `h`
+    so it is destroyed with `arena`. Returns false if the
+    index could not be recorded.
+*/
+bool _mytoml_arena_track(TomlArena *arena, khash_t(index) *h);
+
+/*
+    Functions `_mytoml_alloc`, `_mytoml_realloc` and `_mytoml_free`
+    behave like `calloc`, `realloc` and `free` when `arena` is
+    NULL. Otherwise memory is bumped off the current chunk of
+    `arena`, `_mytoml_realloc` grows or shrinks the last
+    allocation in place when it can, and `_mytoml_free` does
+    nothing since the memory is released with the arena.
+    `_mytoml_realloc` needs the `old` size of `p` to copy it.
+*/
+void *_mytoml_alloc(TomlArena *arena, size_t size);
+
+void *_mytoml_realloc(TomlArena *arena, void *p, size_t old, size_t size);
+
+void _mytoml_free(TomlArena *arena, void *p);
+
 //-----------------------------------------------------------------------------
 // [SECTION] Myjson Value
 //-----------------------------------------------------------------------------
 
 /*
     Function `_mytoml_value_delete` frees up all the memory
-    that is associated with value `v`.
+    that is associated with value `v`, including the elements
+    of an array and the key of an inline table. Values
+    allocated from an `arena` are left to the arena.
+*/
+void _mytoml_value_delete(TomlArena *arena, TomlValue *v);
+
+/*
+    Function `_mytoml_value_new_array` allocates an empty array
+    of `TomlValue` and returns a pointer to it. No storage is
+    allocated for the elements until the first one is added.
+*/
+TomlValue *_mytoml_value_new_array(TomlArena *arena);
+
+/*
+    Function `_mytoml_value_array_push` appends `e` to the `arr`
+    attribute of the array `v`. The storage starts out with
+    `MYTOML_ARRAY_INITIAL_CAPACITY` slots and doubles every time
+    it is full. Returns false if it could not be grown.
 */
-void _mytoml_value_delete(TomlValue *v);
+bool _mytoml_value_array_push(TomlArena *arena, TomlValue *v, TomlValue *e);
 
 /*
-    Function `_mytoml_value_new_array` allocates a buffer for an
-    array of `TomlValue` and returns a pointer to it.
-    This is stored in the `arr` attribute.
+    Function `_mytoml_value_array_shrink` trims the storage of
+    the array `v` to exactly `len` slots. It is called once no
+    more elements will be added to the array.
 */
-TomlValue *_mytoml_value_new_array();
+void _mytoml_value_array_shrink(TomlArena *arena, TomlValue *v);
 
 /*
     Function `_mytoml_value_new_table` takes a key `k` as
     it's argument which can contain one or many key
-    value pairs, including subkeys. It then allocates
-    some new memory for a key and adds all subkeys of
-    `k` as subkeys of this newly allocated key. It
-    returns a pointer to the newly allocated value.
-    The `data` attribute contains the newly created key.
+    value pairs, including subkeys. It allocates a new
+    value that takes ownership of `k`, stored in its
+    `table` attribute, and returns a pointer to it.
 */
-TomlValue *_mytoml_value_new_table(TomlKey *k);
+TomlValue *_mytoml_value_new_table(TomlArena *arena, TomlKey *k);
 
 /*
-    Functions `_mytoml_value_new_string`, `_mytoml_value_new_datetime` and
-   `_mytoml_value_new_number` allocates some memory for each of these datatypes
-    respectively. It then copies over the passed in data
-    into the `data` attribute of the value. Finally, like
-    the other functions, it returns a pointer to the newly
-    allocated value.
+    Functions `_mytoml_value_new_datetime`, `_mytoml_value_new_integer`
+    and `_mytoml_value_new_number` allocates a value for each of
+    these datatypes respectively. The passed in data is stored
+    inline in the value, `_mytoml_value_new_number` stores BOOL
+    values in `boolean` and FLOAT values in `number`. Finally,
+    like the other functions, it returns a pointer to the newly
+    allocated value. `_mytoml_value_new_string` instead takes
+    ownership of `s`, a buffer from `_mytoml_alloc` holding `len`
+    bytes followed by a `\0`, and stores them in `str` and `len`.
 */
-TomlValue *_mytoml_value_new_string(const char *s);
+TomlValue *_mytoml_value_new_string(TomlArena *arena, char *s, int len);
 
-TomlValue *_mytoml_value_new_datetime(struct tm *dt, TomlValueType type, char *format, int millis);
+TomlValue *_mytoml_value_new_datetime(TomlArena *arena, TomlDatetime *dt, TomlValueType type, int precision);
 
-TomlValue *_mytoml_value_new_number(double *d, TomlValueType type, size_t precision, bool scientific);
+TomlValue *_mytoml_value_new_integer(TomlArena *arena, int64_t i);
+
+TomlValue *_mytoml_value_new_number(TomlArena *arena, double *d, TomlValueType type, size_t precision, bool scientific);
 
 //-----------------------------------------------------------------------------
 // [SECTION] Myjson Key
@@ -424,10 +1026,11 @@ TomlValue *_mytoml_value_new_number(double *d, TomlValueType type, size_t precis
     Function `_mytoml_value_new_key` allocates memory to create
     a new key/node in the AST. It takes the key type
     as an argument and initializes everything else
-    to NULL and idx to 0. Returns a pointer to the
-    newly allocated key.
+    to NULL and idx to `TOML_KEY_NO_INDEX`. The key starts with an empty
+    `id` and without subkeys, and allocates nothing for
+    either. Returns a pointer to the newly allocated key.
 */
-TomlKey *_mytoml_value_new_key(TomlKeyType type);
+TomlKey *_mytoml_value_new_key(TomlArena *arena, TomlKeyType type);
 
 /*
     Function `_mytoml_value_delete_key` frees up all the memory allocated
@@ -435,8 +1038,9 @@ TomlKey *_mytoml_value_new_key(TomlKeyType type);
     memory allocated by the keys in `children` if any. Then
     it frees up all the memory allocated by `value` if any.
     Finally, it frees up the memory allocated by itself.
+    Keys allocated from an `arena` are left to the arena.
 */
-void _mytoml_value_delete_key(TomlKey *key);
+void _mytoml_value_delete_key(TomlArena *arena, TomlKey *key);
 
 /*
     Function `_mytoml_value_has_sub_key` checks if a `key` has a `subkey`
@@ -446,6 +1050,16 @@ void _mytoml_value_delete_key(TomlKey *key);
 */
 TomlKey *_mytoml_value_has_sub_key(TomlKey *key, TomlKey *subkey);
 
+/*
+    Function `_mytoml_value_find_sub_key` looks the `length`
+    bytes of `id` up in the `children` of `key` with their
+    precomputed `hash`, so neither the parser nor callers
+    holding a compiled path hash a key twice. Interned ids
+    match by pointer before their bytes are compared. Returns
+    a pointer to the subkey, or NULL if there is none.
+*/
+TomlKey *_mytoml_value_find_sub_key(TomlKey *key, const char *id, size_t length, khint_t hash);
+
 /*
     Function `_mytoml_value_add_sub_key` tries to add `subkey` in the
     list of `children` of `key`. There are checks to do
@@ -457,7 +1071,16 @@ TomlKey *_mytoml_value_has_sub_key(TomlKey *key, TomlKey *subkey);
     added subkey is returned respectively. Otherwise, it
     returns a NULL pointer on failure or buffer overflow.
 */
-TomlKey *_mytoml_value_add_sub_key(TomlKey *key, TomlKey *subkey);
+TomlKey *_mytoml_value_add_sub_key(TomlArena *arena, TomlKey *key, TomlKey *subkey);
+
+/*
+    Function `_mytoml_value_put_sub_key` appends `subkey` with
+    its `hash` to the `children` of `key`, which therefore stay
+    in document order, building the hash
+    index once there are more than `MYTOML_TABLE_INDEX_THRESHOLD`
+    of them. Returns false on allocation failure.
+*/
+bool _mytoml_value_put_sub_key(TomlArena *arena, TomlKey *key, TomlKey *subkey, khint_t hash);
 
 /*
     Function `_mytoml_value_keys_compatible` is used to decide if the
@@ -507,50 +1130,62 @@ bool _mytoml_is_basic_string_start(char c);
 bool _mytoml_is_inline_table_start(char c);
 bool _mytoml_is_literal_string_start(char c);
 bool _mytoml_is_date(int year, int month, int day);
-bool _mytoml_is_number_end(char c, const char *end);
-bool _mytoml_is_valid_datetime(struct tm *datetime);
+bool _mytoml_is_bare_value(char c);
+bool _mytoml_is_base_digit(char c, int base);
+
+/*
+    Functions `_mytoml_scan_special` and `_mytoml_scan_whitespace`
+    look for the end of a run of uninteresting bytes in `s`,
+    starting at `pos` and stopping at `size`, using SIMD where
+    available. `_mytoml_scan_special` stops on `a`, `b` or any
+    control character other than a tab, which covers quotes,
+    backslashes and newlines in strings and comments.
+    `_mytoml_scan_whitespace` stops on anything that is not a
+    space or a tab. Both return the offset they stopped at,
+    which is `size` if the run reaches the end of the input.
+*/
+size_t _mytoml_scan_special(const char *s, size_t pos, size_t size, char a, char b);
+
+size_t _mytoml_scan_whitespace(const char *s, size_t pos, size_t size);
+
+/*
+    Function `_mytoml_scan_line` skips the line starting at
+    `pos` without parsing it, to find where statements end.
+    `depth` counts the brackets and braces left open and
+    `quote` is the quote of a multi-line string left open, or
+    0, before the line on entry and after it on return. Both
+    are kept across lines, while comments and other strings
+    end with the line. Returns the offset after the newline,
+    or 0 if the line is cut by `size`, leaving `depth` and
+    `quote` undefined.
+*/
+size_t _mytoml_scan_line(const char *s, size_t pos, size_t size, int *depth, char *quote);
 
 //-----------------------------------------------------------------------------
 // [SECTION] Myjson Parser Key
 //-----------------------------------------------------------------------------
 
 /*
-    Functions `_mytoml_parser_bare_key`, `_mytoml_parser_basic_quoted_key`
-    and `_mytoml_parser_literal_quoted_key` parses a "bare key",
-    a "basic quoted key" and a "literal quoted key"
-    respectively, as defined by the TOML spec. The caller
-    should decide which one is being parsed. They use `.`
-    and `=` as delimiters. Once it has successfully parsed
-    a key, it creates a key and returns a pointer to it.
-    All of them log errors and return NULL on parsing
-    failure. The key types `branch` and `leaf` passed as
-    arguments determine the key types of keys created upon
-    encountering a `.` and a `=` respectively. The `end`
-    argument determines which character marks the termination
-    of parsing.
+    Function `_mytoml_parser_parse_key_id` interns the key
+    held by the `current` token. Bare keys are interned
+    straight from the input while quoted keys are decoded
+    like their string counterparts first. Returns the
+    interned id, or NULL if the token is not a key.
 */
-TomlKey *_mytoml_parser_bare_key(Tokenizer *tok, char end, TomlKeyType branch, TomlKeyType leaf);
-
-TomlKey *_mytoml_parser_basic_quoted_key(Tokenizer *tok, char end, TomlKeyType branch, TomlKeyType leaf);
-
-TomlKey *_mytoml_parser_literal_quoted_key(Tokenizer *tok, char end, TomlKeyType branch, TomlKeyType leaf);
+const char *_mytoml_parser_parse_key_id(Tokenizer *tok);
 
 /*
-    Functions `_mytoml_parser_parse_key`, `_mytoml_parser_parse_table` and
-    `_mytoml_parser_parse_array_table` tries to parse a TOML
-    key, table and arraytable respectively. It
-    takes a `key` as its argument meaning the
-    new key(s) that is(are) parsed will be added
-    to the `subkeys` of `key`. Setting `expecting`
-    to `true` will throw an error if we encounter
-    a delimiter like `.` or `=`. Returns NULL on
-    parsing failure.
+    Function `_mytoml_parser_parse_key` parses a (dotted)
+    key starting at the `current` token and adds each part
+    to the `subkeys` of `key`. Parts followed by a `.` are
+    created with the `branch` type and the last part with
+    the `leaf` type, which is how the same function parses
+    `a.b = c` (KEY, KEYLEAF), `[a.b]` (TABLE, TABLELEAF) and
+    `[[a.b]]` (TABLE, ARRAYTABLE). Parsing stops on the `end`
+    token which is left as the `current` token. Returns the
+    last part, or NULL on parsing failure.
 */
-TomlKey *_mytoml_parser_parse_key(Tokenizer *tok, TomlKey *key, bool expecting);
-
-TomlKey *_mytoml_parser_parse_table(Tokenizer *tok, TomlKey *key, bool expecting);
-
-TomlKey *_mytoml_parser_parse_array_table(Tokenizer *tok, TomlKey *key, bool expecting);
+TomlKey *_mytoml_parser_parse_key(Tokenizer *tok, TomlKey *key, TomlKeyType branch, TomlKeyType leaf, TokenType end);
 
 /*
     Function `_mytoml_parser_parse_key_value` tries to parse a key
@@ -573,103 +1208,712 @@ TomlKey *_mytoml_parser_parse_key_value(Tokenizer *tok, TomlKey *key, TomlKey *r
 
 /*
     Functions `parse_<TYPE>` parses a TOML value of type
-    TYPE. They take the tokenizer and parses one character
-    at a time. Numerical values and datetimes have a list
-    of characters to mark the end of parsing. Strings take
-    in pre-allocated buffers. Arrays repeatedly parse values.
-    Inline tables repeatedly parse key-value pairs. Everything
-    returns a pointer to what it parsed and NULL on parsing
-    failure. `_mytoml_parser_parse_comment` returns true if a valid comment
-    was parsed and `_mytoml_parser_parse_newline` returns true if a newline
-    was successfully parsed.
-*/
-bool _mytoml_parser_parse_comment(Tokenizer *tok);
-
+    TYPE. Scalars are parsed in place from the span of the
+    `current` token: numbers and datetimes are read straight
+    out of the input, and strings are decoded into a buffer
+    sized from the token. Arrays repeatedly parse values.
+    Inline tables repeatedly parse key-value pairs into the
+    `subkeys` of their `owner` key. Everything returns a
+    pointer to what it parsed and NULL on parsing failure.
+    `_mytoml_parser_parse_newline` returns true if a newline
+    was successfully parsed and `_mytoml_parser_parse_line_end`
+    returns true if nothing but whitespace and a comment is
+    left on the line.
+*/
 void _mytoml_parser_parse_whitespace(Tokenizer *tok);
 
 bool _mytoml_parser_parse_newline(Tokenizer *tok);
 
-double _mytoml_parser_parse_boolean(Tokenizer *tok);
+bool _mytoml_parser_parse_line_end(Tokenizer *tok);
 
-TomlKey *_mytoml_parser_parse_inline_tabel(Tokenizer *tok);
+TomlKey *_mytoml_parser_parse_inline_tabel(Tokenizer *tok, TomlKey *owner);
+
+/*
+    Function `_mytoml_parser_parse_leaf_value` parses the value
+    of the KEYLEAF `leaf`. Inline tables are parsed directly
+    into the `subkeys` of `leaf`, any other value is stored
+    in its `value` attribute. Returns false on parsing failure.
+*/
+bool _mytoml_parser_parse_leaf_value(Tokenizer *tok, TomlKey *leaf);
 
 int _mytoml_parser_parse_escape(Tokenizer *tok, char *escaped, int len);
 
 int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len);
 
-char *_mytoml_parser_parse_basic_string(Tokenizer *tok, char *value, bool multi);
+char *_mytoml_parser_parse_basic_string(Tokenizer *tok, char *value, int size, int *len, bool multi);
+
+char *_mytoml_parser_parse_literal_string(Tokenizer *tok, char *value, int size, int *len, bool multi);
 
-char *_mytoml_parser_parse_literal_string(Tokenizer *tok, char *value, bool multi);
+/*
+    Function `_mytoml_parser_parse_string` decodes the string
+    held by the `current` token into `value`, which can hold
+    `size` bytes, and stores the decoded length in `len`. No
+    string decodes to more bytes than its body in the input,
+    so callers size `value` from the token. Bodies without
+    escapes or control characters are copied as is.
+*/
+char *_mytoml_parser_parse_string(Tokenizer *tok, char *value, int size, int *len);
+
+int _mytoml_parser_parse_digits(const char *s, int len, int *i, int base, char *value, int *idx);
+
+/*
+    Function `_mytoml_parser_parse_integer` converts the `len`
+    bytes at `s` to a 64-bit integer in `base`, accumulating
+    the digits directly without going through a double. Only
+    decimal integers may have a sign. Underscores must be
+    surrounded by digits. Returns false if `s` is not an
+    integer or does not fit in 64 bits.
+*/
+bool _mytoml_parser_parse_integer(const char *s, int len, int base, int64_t *value);
+
+/*
+    Function `_mytoml_parser_parse_significand` reads a run of
+    decimal digits, like `_mytoml_parser_parse_digits`, into
+    `d`. Digits after the decimal point lower the exponent
+    and integer digits past the 19th raise it. Returns the
+    number of digits read.
+*/
+int _mytoml_parser_parse_significand(const char *s, int len, int *i, Decimal *d, bool fraction);
 
-double _mytoml_parser_parse_lnf_nan(Tokenizer *tok, bool negative);
+/*
+    Function `_mytoml_parser_parse_float` converts `d` to the
+    nearest double. Mantissas of up to 53 bits scaled by a
+    power of ten that is exact in a double are converted
+    with a single multiplication or division. Other values
+    are written to a scratch buffer as digits and an exponent,
+    with no decimal point so the locale cannot change the
+    result, and converted with `strtod`.
+*/
+bool _mytoml_parser_parse_float(const char *s, int len, Decimal *d, double *number);
 
-double _mytoml_parser_parse_base_unit(Tokenizer *tok, int base, char *value, const char *num_end);
+/*
+    Function `_mytoml_parser_parse_number` converts the `len`
+    bytes at `s` into `n`. Integers, including hexadecimal,
+    octal and binary ones, are stored in `integer` and floats
+    in `number`. Tokens of `MYTOML_MAX_NUMBER_LENGTH` bytes or
+    more are rejected.
+*/
+Number *_mytoml_parser_parse_number(const char *s, int len, Number *n);
 
-Number *_mytoml_parser_parse_number(Tokenizer *tok, char *value, double *d, const char *num_end, Number *n);
+/*
+    Function `_mytoml_parser_parse_datetime` parses the `len`
+    bytes at `s` in a single pass, reading every field from
+    its fixed RFC 3339 position. It tells an offset datetime,
+    local datetime, local date and local time apart as it goes
+    and stores the packed fields, type and fraction digits in
+    `dt`. Returns `dt`, or NULL if `s` is not a datetime.
+*/
+Datetime *_mytoml_parser_parse_datetime(const char *s, int len, Datetime *dt);
 
-Datetime *_mytoml_parser_parse_datetime(Tokenizer *tok, char *value, const char *num_end, struct tm *time);
+/*
+    Function `_mytoml_parser_parse_fixed` converts exactly `n`
+    decimal digits at `s`. Returns -1 if any of them is not a
+    digit.
+*/
+int _mytoml_parser_parse_fixed(const char *s, int n);
 
 TomlValue *_mytoml_parser_parse_array(Tokenizer *tok, TomlValue *arr);
 
 /*
-    Function `_mytoml_parser_parse_value` looks at a character
-    and decides what `TYPE` it is. Depending on that,
-    it calls the appropriate `parse_<TYPE>` function.
-    Since the `num_end` character set changes based
-    on parsing context (for example, a number can end
-    when we see a `,` when parsing an array), this
-    is added as an argument to this function. This
-    allows it to be used anywhere a value needs to be
-    parsed.
+    Function `_mytoml_parser_parse_value` looks at the
+    `current` token and decides what `TYPE` it is.
+    Depending on that, it calls the appropriate
+    `parse_<TYPE>` function. On success the token
+    following the value is left as the `current` token,
+    which allows it to be used anywhere a value needs
+    to be parsed.
+*/
+TomlValue *_mytoml_parser_parse_value(Tokenizer *tok);
+
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Parallel
+//-----------------------------------------------------------------------------
+
+/*
+    Function `_mytoml_parallel_split` looks for places to cut
+    the `size` bytes at `s` into `n` chunks that can be parsed
+    on their own. A chunk may only start on a line holding a
+    `[table]` or `[[array]]` header, so the input is scanned
+    once for lines starting with `[` outside of strings,
+    comments and multi-line arrays or inline tables. The first
+    such line at or after every `k * size / n` is stored in
+    `split`, which has room for `n - 1` offsets. Returns the
+    number of offsets stored.
+*/
+int _mytoml_parallel_split(const char *s, size_t size, size_t *split, int n);
+
+/*
+    Function `_mytoml_parallel_merge` moves the subkeys of
+    `from`, a key of a chunk that follows the one `into` was
+    parsed from, into `into`. Each subkey is re-added with the
+    rules of `_mytoml_value_keys_compatible`, exactly as if the
+    chunk had been parsed after `into`: new keys are moved over,
+    keys defined by both are merged recursively and elements of
+    arrays of tables are appended. Moved keys and elements are
+    cleared in `from` so it can still be freed. Returns false on
+    an invalid re-definition or allocation failure. Every array
+    of tables continued by `from` is counted off `continued`.
+*/
+bool _mytoml_parallel_merge(TomlArena *arena, TomlKey *into, TomlKey *from, int *continued);
+
+/*
+    Function `_mytoml_parallel_continue` is called in every
+    chunk but the first before an `[[array]]` header adds the
+    subkey `id` to `key`. A chunk may start in the middle of an
+    element, as in `[hosts.meta]` followed by `[[hosts]]`, so an
+    implicit table of that name is turned into an array of
+    tables whose first element, a `TOML_TABLE` key instead of a
+    `TOML_KEY`, holds the rest of the element. The merge moves
+    its subkeys into the last element of the array from the
+    earlier chunks, and fails if there is no such array.
+    Returns false on allocation failure.
 */
-TomlValue *_mytoml_parser_parse_value(Tokenizer *tok, const char *num_end);
+bool _mytoml_parallel_continue(Tokenizer *tok, TomlKey *key, const char *id);
 
 //-----------------------------------------------------------------------------
 // [SECTION] Definations
 //-----------------------------------------------------------------------------
 
-void _mytoml_append_to_buffer(char **buffer, size_t *size, const char *format, ...) {
-    va_list args;
-    va_start(args, format);
-    size_t needed = vsnprintf(NULL, 0, format, args) + 1;
-    va_end(args);
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Writer
+//-----------------------------------------------------------------------------
+
+bool _mytoml_writer_flush(Writer *w) {
+    if (w->failed) return false;
+    if (w->len > 0 && w->sink(w->data, w->len, w->user) != w->len) {
+        w->failed = true;
+        return false;
+    }
+    w->flushed += w->len;
+    w->len = 0;
+    return true;
+}
+
+bool _mytoml_writer_grow(Writer *w, size_t n) {
+    if (w->failed) return false;
+    if (w->sink != NULL) return _mytoml_writer_flush(w) && n + 1 <= w->cap;
+    size_t cap = (w->cap > 0) ? w->cap : MYTOML_WRITER_INITIAL_CAPACITY;
+    while (cap < w->len + n + 1) cap *= 2;
+    char *data = (char *)realloc(w->data, cap);
+    if (data == NULL) {
+        w->failed = true;
+        return false;
+    }
+    w->data = data;
+    w->cap = cap;
+    return true;
+}
+
+void _mytoml_writer_take(Writer *w, char **buffer, size_t *size) {
+    // even empty output is a terminated buffer
+    if (w->len + 1 > w->cap) _mytoml_writer_grow(w, 0);
+    if (w->failed) {
+        free(w->data);
+        *buffer = NULL;
+        *size = 0;
+        return;
+    }
+    w->data[w->len] = '\0';
+    *buffer = w->data;
+    *size = w->len;
+}
+
+static inline void _mytoml_writer_write(Writer *w, const char *s, size_t n) {
+    if (w->sink != NULL) {
+        // feed writes larger than the staging buffer through it in pieces
+        while (w->len + n + 1 > w->cap) {
+            size_t chunk = w->cap - w->len - 1;
+            memcpy(w->data + w->len, s, chunk);
+            w->len += chunk;
+            s += chunk;
+            n -= chunk;
+            if (!_mytoml_writer_flush(w)) return;
+        }
+    } else if (w->len + n + 1 > w->cap && !_mytoml_writer_grow(w, n)) {
+        return;
+    }
+    memcpy(w->data + w->len, s, n);
+    w->len += n;
+}
 
-    *buffer = (char *)realloc(*buffer, *size + needed);
+void _mytoml_writer_format(Writer *w, const char *format, ...) {
+    va_list args;
+    size_t avail = (w->cap > w->len) ? w->cap - w->len : 0;
     va_start(args, format);
-    vsnprintf(*buffer + *size, needed, format, args);
+    int needed = vsnprintf(avail ? w->data + w->len : NULL, avail, format, args);
     va_end(args);
-
-    *size += needed - 1;
+    if (needed < 0) return;
+    if ((size_t)needed >= avail) {
+        if (_mytoml_writer_grow(w, needed)) {
+            va_start(args, format);
+            vsnprintf(w->data + w->len, w->cap - w->len, format, args);
+            va_end(args);
+        } else if (!w->failed) {
+            // too long for the staging buffer of a sink, format it aside
+            char *text = (char *)malloc(needed + 1);
+            if (text == NULL) return;
+            va_start(args, format);
+            vsnprintf(text, needed + 1, format, args);
+            va_end(args);
+            _mytoml_writer_write(w, text, needed);
+            free(text);
+            return;
+        } else {
+            return;
+        }
+    }
+    w->len += needed;
 }
 
-static inline void _mytoml_string_dump(const char *s, char **buffer, size_t *size) {
-    for (const char *c = s; *c != '\0'; c++) {
-        switch (*c) {
+void _mytoml_writer_escape(Writer *w, const char *s, size_t n) {
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\' && c != 0x7F) continue;
+        // flush the run of plain bytes before the escape
+        _mytoml_writer_write(w, s + start, i - start);
+        start = i + 1;
+        switch (c) {
             case '\b':
-                _mytoml_append_to_buffer(buffer, size, "\\b");
-                continue;
+                WRITE_LITERAL(w, "\\b");
+                break;
             case '\n':
-                _mytoml_append_to_buffer(buffer, size, "\\n");
-                continue;
+                WRITE_LITERAL(w, "\\n");
+                break;
             case '\r':
-                _mytoml_append_to_buffer(buffer, size, "\\r");
-                continue;
+                WRITE_LITERAL(w, "\\r");
+                break;
             case '\t':
-                _mytoml_append_to_buffer(buffer, size, "\\t");
-                continue;
+                WRITE_LITERAL(w, "\\t");
+                break;
             case '\f':
-                _mytoml_append_to_buffer(buffer, size, "\\f");
-                continue;
+                WRITE_LITERAL(w, "\\f");
+                break;
             case '\\':
-                _mytoml_append_to_buffer(buffer, size, "\\\\");
-                continue;
+                WRITE_LITERAL(w, "\\\\");
+                break;
             case '"':
-                _mytoml_append_to_buffer(buffer, size, "\\\"");
-                continue;
+                WRITE_LITERAL(w, "\\\"");
+                break;
             default:
+                _mytoml_writer_format(w, "\\u%04x", c);
                 break;
         }
-        _mytoml_append_to_buffer(buffer, size, "%c", *c);
+    }
+    _mytoml_writer_write(w, s + start, n - start);
+}
+
+static const char _mytoml_digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+int _mytoml_format_integer(int64_t value, char *buffer) {
+    char digits[20];
+    char *end = digits + sizeof(digits), *p = end;
+    uint64_t u = (value < 0) ? 0 - (uint64_t)value : (uint64_t)value;
+    while (u >= 100) {
+        unsigned int pair = (unsigned int)(u % 100) * 2;
+        u /= 100;
+        *--p = _mytoml_digit_pairs[pair + 1];
+        *--p = _mytoml_digit_pairs[pair];
+    }
+    if (u >= 10) {
+        *--p = _mytoml_digit_pairs[u * 2 + 1];
+        *--p = _mytoml_digit_pairs[u * 2];
+    } else {
+        *--p = (char)('0' + u);
+    }
+    int n = 0;
+    if (value < 0) buffer[n++] = '-';
+    memcpy(buffer + n, p, end - p);
+    return n + (int)(end - p);
+}
+
+// 10^k for k = -300, -292, ..., 324, see `_mytoml_grisu_cached_power`
+static const CachedPower _mytoml_cached_powers[] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324},
+};
+
+static inline DiyFp _mytoml_diyfp_mul(DiyFp x, DiyFp y) {
+    // upper 64 bits of the 128-bit product, rounded
+    uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFFu;
+    uint64_t c = y.f >> 32, d = y.f & 0xFFFFFFFFu;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t mid = (bd >> 32) + (ad & 0xFFFFFFFFu) + (bc & 0xFFFFFFFFu) + (1u << 31);
+    return (DiyFp){ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64};
+}
+
+static inline DiyFp _mytoml_diyfp_normalize(DiyFp x) {
+    while ((x.f >> 63) == 0) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+static inline CachedPower _mytoml_grisu_cached_power(int e) {
+    // pick 10^k so that the scaled exponent lands in [-60, -32]
+    int f = -60 - e - 1;
+    int k = (f * 78913) / (1 << 18) + (f > 0);
+    int index = (300 + k + 7) / 8;
+    return _mytoml_cached_powers[index];
+}
+
+static inline void _mytoml_grisu_round(char *buffer, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+    // move the last digit towards `w` while it stays inside the boundaries
+    while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+        buffer[len - 1]--;
+        rest += ten_k;
+    }
+}
+
+static int _mytoml_grisu_digits(char *buffer, int *exponent, DiyFp low, DiyFp w, DiyFp high) {
+    uint64_t delta = high.f - low.f;
+    uint64_t dist = high.f - w.f;
+    int shift = -high.e;
+    uint64_t one = (uint64_t)1 << shift;
+    uint32_t integral = (uint32_t)(high.f >> shift);
+    uint64_t fraction = high.f & (one - 1);
+
+    uint32_t pow10 = 1;
+    int n = 1;
+    while (n < 10 && integral >= pow10 * 10) {
+        pow10 *= 10;
+        n++;
+    }
+
+    int len = 0;
+    while (n > 0) {
+        buffer[len++] = (char)('0' + integral / pow10);
+        integral %= pow10;
+        n--;
+        uint64_t rest = ((uint64_t)integral << shift) + fraction;
+        if (rest <= delta) {
+            *exponent += n;
+            _mytoml_grisu_round(buffer, len, dist, delta, rest, (uint64_t)pow10 << shift);
+            return len;
+        }
+        pow10 /= 10;
+    }
+
+    int m = 0;
+    do {
+        fraction *= 10;
+        buffer[len++] = (char)('0' + (fraction >> shift));
+        fraction &= one - 1;
+        delta *= 10;
+        dist *= 10;
+        m++;
+    } while (fraction > delta);
+    *exponent -= m;
+    _mytoml_grisu_round(buffer, len, dist, delta, fraction, one);
+    return len;
+}
+
+int _mytoml_format_float(double value, char *buffer) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int n = 0;
+    if (bits >> 63) buffer[n++] = '-';
+    if (value == 0) {
+        memcpy(buffer + n, "0.0", 3);
+        return n + 3;
+    }
+
+    // the boundaries halfway to the neighbouring doubles
+    uint64_t fraction = bits & (((uint64_t)1 << 52) - 1);
+    int biased = (int)((bits >> 52) & 0x7FF);
+    DiyFp v = (biased == 0) ? (DiyFp){fraction, -1074} : (DiyFp){fraction | ((uint64_t)1 << 52), biased - 1075};
+    DiyFp high = _mytoml_diyfp_normalize((DiyFp){(v.f << 1) + 1, v.e - 1});
+    DiyFp low = (fraction == 0 && biased > 1) ? (DiyFp){(v.f << 2) - 1, v.e - 2} : (DiyFp){(v.f << 1) - 1, v.e - 1};
+    low.f <<= low.e - high.e;
+    low.e = high.e;
+    v = _mytoml_diyfp_normalize(v);
+
+    CachedPower c = _mytoml_grisu_cached_power(high.e);
+    DiyFp cached = {c.f, c.e};
+    DiyFp w = _mytoml_diyfp_mul(v, cached);
+    low = _mytoml_diyfp_mul(low, cached);
+    high = _mytoml_diyfp_mul(high, cached);
+    low.f++;
+    high.f--;
+
+    char digits[18];
+    int exponent = -c.k;
+    int len = _mytoml_grisu_digits(digits, &exponent, low, w, high);
+    if (len > 15) {
+        // Grisu2 is not always shortest; when 15 digits round-trip the
+        // nearest 15-digit decimal is, once its trailing zeros are gone
+        char text[32];
+        snprintf(text, sizeof(text), "%.14e", fabs(value));
+        if (strtod(text, NULL) == fabs(value)) {
+            digits[0] = text[0];
+            memcpy(digits + 1, text + 2, 14);
+            len = 15;
+            while (len > 1 && digits[len - 1] == '0') len--;
+            exponent = atoi(text + 17) - (len - 1);
+        }
+    }
+
+    // place the decimal point like `%g` would, but never lose digits
+    int point = len + exponent;
+    char *out = buffer + n;
+    if (len <= point && point <= 15) {
+        memcpy(out, digits, len);
+        memset(out + len, '0', point - len);
+        memcpy(out + point, ".0", 2);
+        return n + point + 2;
+    }
+    if (0 < point && point <= 15) {
+        memcpy(out, digits, point);
+        out[point] = '.';
+        memcpy(out + point + 1, digits + point, len - point);
+        return n + len + 1;
+    }
+    if (-5 < point && point <= 0) {
+        memcpy(out, "0.", 2);
+        memset(out + 2, '0', -point);
+        memcpy(out + 2 - point, digits, len);
+        return n + 2 - point + len;
+    }
+    int i = 0;
+    out[i++] = digits[0];
+    if (len > 1) {
+        out[i++] = '.';
+        memcpy(out + i, digits + 1, len - 1);
+        i += len - 1;
+    }
+    out[i++] = 'e';
+    out[i++] = (point - 1 < 0) ? '-' : '+';
+    i += _mytoml_format_integer((point - 1 < 0) ? 1 - point : point - 1, out + i);
+    return n + i;
+}
+
+static inline void _mytoml_writer_integer(Writer *w, int64_t value) {
+    char text[20];
+    _mytoml_writer_write(w, text, _mytoml_format_integer(value, text));
+}
+
+static inline void _mytoml_writer_float(Writer *w, double value) {
+    char text[32];
+    int n = MYTOML_FORMAT_FLOAT(value, text);
+    _mytoml_writer_write(w, text, n);
+    if (memchr(text, '.', n) == NULL && memchr(text, 'e', n) == NULL && memchr(text, 'E', n) == NULL) WRITE_LITERAL(w, ".0");
+}
+
+static inline void _mytoml_datetime_dump(Writer *w, const TomlValue *v, int min_precision) {
+    const TomlDatetime *dt = &v->datetime;
+    int precision = (v->precision > 0 && v->precision < min_precision) ? min_precision : v->precision;
+    if (v->type != TOML_TIMELOCAL) {
+        _mytoml_writer_format(w, "%04d-%02d-%02d", dt->year, dt->month, dt->day);
+        if (v->type == TOML_DATELOCAL) return;
+        WRITE_LITERAL(w, "T");
+    }
+    _mytoml_writer_format(w, "%02d:%02d:%02d", dt->hour, dt->minute, dt->second);
+    if (precision > 0) {
+        unsigned int fraction = dt->nanosecond;
+        for (int i = precision; i < 9; i++) fraction /= 10;
+        _mytoml_writer_format(w, ".%0*u", precision, fraction);
+    }
+    if (v->type != TOML_DATETIME) return;
+    if (dt->flags & TOML_DATETIME_ZULU) {
+        WRITE_LITERAL(w, "Z");
+    } else {
+        int offset = (dt->offset < 0) ? -dt->offset : dt->offset;
+        _mytoml_writer_format(w, "%c%02d:%02d", (dt->offset < 0) ? '-' : '+', offset / 60, offset % 60);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Intern
+//-----------------------------------------------------------------------------
+
+// identifier of keys that were never named, e.g. array table elements
+static const struct {
+    uint32_t hash;
+    uint32_t length;
+    char bytes[1];
+} _mytoml_empty_id = {0, 0, ""};
+
+static inline khint_t _mytoml_hash(const char *s, size_t n) {
+    if (n == 0) return 0;
+    khint_t h = (khint_t)*s;
+    for (size_t i = 1; i < n; i++) h = (h << 5) - h + (khint_t)s[i];
+    return h;
+}
+
+const char *_mytoml_intern(InternPool *pool, const char *s, size_t n) {
+    IdSpan span = {s, (uint32_t)n, _mytoml_hash(s, n)};
+    khash_t(id) *h = pool->ids;
+    khint_t i = kh_get(id, h, span);
+    if (i != kh_end(h)) return kh_key(h, i).bytes;
+    InternedId *e = (InternedId *)_mytoml_alloc(pool->arena, sizeof(InternedId) + n + 1);
+    if (e == NULL) return NULL;
+    e->hash = span.hash;
+    e->length = (uint32_t)n;
+    memcpy(e->bytes, s, n);
+    e->bytes[n] = '\0';
+    // the set refers to the copy, not to the input
+    span.bytes = e->bytes;
+    int ret;
+    kh_put(id, h, span, &ret);
+    if (ret < 0) {
+        // nothing refers to the copy yet
+        _mytoml_free(pool->arena, e);
+        return NULL;
+    }
+    return e->bytes;
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Path
+//-----------------------------------------------------------------------------
+
+int _mytoml_path_parse(const char *path, PathSegment *segment, char *ids) {
+    const char *c = path;
+    int n = 0;
+    for (;;) {
+        while (*c == ' ' || *c == '\t') c++;
+        char *id = ids;
+        if (*c == '"' || *c == '\'') {
+            char quote = *c++;
+            while (*c != quote) {
+                if (*c == '\0') return -1;
+                char ch = *c++;
+                if (quote == '"' && ch == '\\') {
+                    switch (*c++) {
+                        case '"':
+                            ch = '"';
+                            break;
+                        case '\\':
+                            ch = '\\';
+                            break;
+                        case 'b':
+                            ch = '\b';
+                            break;
+                        case 't':
+                            ch = '\t';
+                            break;
+                        case 'n':
+                            ch = '\n';
+                            break;
+                        case 'f':
+                            ch = '\f';
+                            break;
+                        case 'r':
+                            ch = '\r';
+                            break;
+                        default:
+                            return -1;
+                    }
+                }
+                if (ids) *ids++ = ch;
+            }
+            c++;
+        } else {
+            if (!_mytoml_is_bare_ascii(*c)) return -1;
+            while (_mytoml_is_bare_ascii(*c)) {
+                if (ids) *ids++ = *c;
+                c++;
+            }
+        }
+        if (segment) {
+            segment[n] = (PathSegment){id, ids - id, _mytoml_hash(id, ids - id), 0};
+            *ids++ = '\0';
+        }
+        n++;
+        while (*c == ' ' || *c == '\t') c++;
+        while (*c == '[') {
+            c++;
+            if (!_mytoml_is_digit(*c)) return -1;
+            size_t index = 0;
+            while (_mytoml_is_digit(*c)) index = index * 10 + (*c++ - '0');
+            if (*c++ != ']') return -1;
+            if (segment) segment[n] = (PathSegment){NULL, 0, 0, index};
+            n++;
+            while (*c == ' ' || *c == '\t') c++;
+        }
+        if (*c == '\0') return n;
+        if (*c++ != '.') return -1;
     }
 }
 
@@ -679,42 +1923,21 @@ static inline void _mytoml_string_dump(const char *s, char **buffer, size_t *siz
 
 Tokenizer *_mytoml_new_tokenizer(Input input) {
     Tokenizer *tok = (Tokenizer *)calloc(1, sizeof(Tokenizer));
+    if (tok == NULL) return NULL;
     tok->input = input;
     tok->cursor = 0;
     tok->token = '\0';
-    tok->prev = '\0';
-    tok->prev_prev = '\0';
-    tok->line = 0;
-    tok->col = 0;
     tok->is_null = true;
-    memset(tok->lines, 0, MYTOML_MAX_NUM_LINES);
+    tok->error = (TomlError_t){TOML_OK, NULL, 0, 0};
     return tok;
 }
 
 int _mytoml_tokenizer_next_token(Tokenizer *tok) {
-    tok->prev_prev = tok->prev;
-    tok->prev = tok->token;
     if (tok->is_null || tok->cursor == 0) {
-        tok->token = tok->input.stream[tok->cursor++];
-        // if we parsed some non-whitespace character since we saw
-        // the newline, then we aren't on a newline anymore
-        if (tok->newline && tok->prev && tok->prev != ' ' && tok->prev != '\t' && tok->prev != '\n') {
-            tok->newline = false;
-        }
-        if (tok->token == '\n') {
-            tok->newline = true;
-        }
-        if (tok->prev == '\n') {
-            if (tok->line < MYTOML_MAX_NUM_LINES) {
-                tok->lines[tok->line] = tok->col;
-            }
-            tok->line++;
-            tok->col = 0;
-        } else {
-            tok->col++;
-        }
-        if (tok->token == EOF) {
-            tok->token = '\0';
+        // the input is not terminated, reading at `size` yields the end
+        size_t pos = (size_t)tok->cursor++;
+        tok->token = (pos < tok->input.size) ? tok->input.stream[pos] : '\0';
+        if (pos >= tok->input.size) {
             tok->is_null = false;
         }
         return 1;
@@ -722,34 +1945,191 @@ int _mytoml_tokenizer_next_token(Tokenizer *tok) {
     return 0;
 }
 
-void _mytoml_tokenizer_backtrace(Tokenizer *tok, int count) {
-    int pre_count = count + 2;
-    if (count > 0 && tok->cursor > pre_count) {
-        tok->cursor -= pre_count;
-        tok->is_null = true;
-        int col = tok->col;
-        while (tok->line >= 0 && pre_count > col) {
-            pre_count -= col;
-            col = tok->lines[--tok->line];
-        }
-        tok->col = col - pre_count;
-        if (tok->line < 0) tok->line = 0;
-        if (tok->col < 0) tok->col = 0;
-        _mytoml_tokenizer_next_token(tok);
-        _mytoml_tokenizer_next_token(tok);
+char _mytoml_tokenizer_peek(Tokenizer *tok, int n) {
+    // `cursor` already points past `token`
+    size_t pos = (size_t)tok->cursor + n - 1;
+    return (pos < tok->input.size) ? tok->input.stream[pos] : '\0';
+}
+
+void _mytoml_tokenizer_seek(Tokenizer *tok, int pos) {
+    tok->cursor = pos;
+    tok->token = '\0';
+    tok->is_null = true;
+    _mytoml_tokenizer_next_token(tok);
+}
+
+TokenType _mytoml_lexer_next(Tokenizer *tok, bool value) {
+    const char *s = tok->input.stream;
+    int size = (int)tok->input.size;
+    int pos = tok->cursor;
+    int end = pos + 1;
+    TokenType type = T_INVALID;
+
+    if (pos >= size) {
+        type = T_EOF;
+        end = pos;
     } else {
-        LOG_ERR("not enough characters to _mytoml_tokenizer_backtrace %d\n", count);
+        switch (s[pos]) {
+            case ' ':
+            case '\t':
+                end = (int)_mytoml_scan_whitespace(s, end, size);
+                type = T_WHITESPACE;
+                break;
+            case '\n':
+                type = T_NEWLINE;
+                break;
+            case '\r':
+                // a lone carriage return is not a newline
+                if (end < size && _mytoml_is_newline(s[end])) {
+                    end++;
+                    type = T_NEWLINE;
+                }
+                break;
+            case '#':
+                type = T_COMMENT;
+                // the only control characters that may end a comment are newlines
+                end = (int)_mytoml_scan_special(s, end, size, '\n', '\n');
+                if (end < size && !_mytoml_is_newline(s[end]) && !(_mytoml_is_return(s[end]) && end + 1 < size && _mytoml_is_newline(s[end + 1]))) {
+                    type = T_INVALID;
+                }
+                break;
+            case '"':
+            case '\'': {
+                char q = s[pos];
+                bool basic = (q == '"');
+                if (pos + 2 < size && s[pos + 1] == q && s[pos + 2] == q) {
+                    // multi-line strings may end with up to
+                    // two quotes right before the delimiter
+                    end = pos + 3;
+                    while ((end = (int)_mytoml_scan_special(s, end, size, q, basic ? '\\' : q)) < size) {
+                        if (basic && _mytoml_is_escape(s[end])) {
+                            end += 2;
+                        } else if (s[end] == q && end + 2 < size && s[end + 1] == q && s[end + 2] == q) {
+                            int run = 3;
+                            while (end + run < size && s[end + run] == q) run++;
+                            if (run <= 5) {
+                                end += run;
+                                type = basic ? T_ML_BASIC_STRING : T_ML_LITERAL_STRING;
+                            }
+                            break;
+                        } else {
+                            end++;
+                        }
+                    }
+                } else {
+                    while ((end = (int)_mytoml_scan_special(s, end, size, q, basic ? '\\' : q)) < size) {
+                        if (s[end] == q || _mytoml_is_newline(s[end])) break;
+                        end += (basic && _mytoml_is_escape(s[end])) ? 2 : 1;
+                    }
+                    if (end < size && s[end] == q) {
+                        end++;
+                        type = basic ? T_BASIC_STRING : T_LITERAL_STRING;
+                    }
+                }
+                if (end > size) end = size;
+                break;
+            }
+            case '.':
+                type = T_DOT;
+                break;
+            case '=':
+                type = T_EQUAL;
+                break;
+            case ',':
+                type = T_COMMA;
+                break;
+            case '{':
+                type = T_LBRACE;
+                break;
+            case '}':
+                type = T_RBRACE;
+                break;
+            case '[':
+                type = T_LBRACKET;
+                if (!value && end < size && s[end] == '[') {
+                    end++;
+                    type = T_DLBRACKET;
+                }
+                break;
+            case ']':
+                type = T_RBRACKET;
+                if (!value && end < size && s[end] == ']') {
+                    end++;
+                    type = T_DRBRACKET;
+                }
+                break;
+            default:
+                if (value ? _mytoml_is_bare_value(s[pos]) : _mytoml_is_bare_ascii(s[pos])) {
+                    type = T_BARE;
+                    while (end < size && (value ? _mytoml_is_bare_value(s[end]) : _mytoml_is_bare_ascii(s[end]))) {
+                        end++;
+                        // `YYYY-MM-DD HH:MM:SS` is a single datetime
+                        if (value && end - pos == 10 && s[pos + 4] == '-' && s[pos + 7] == '-' && end + 3 < size && s[end] == ' ' &&
+                            _mytoml_is_digit(s[end + 1]) && _mytoml_is_digit(s[end + 2]) && s[end + 3] == ':') {
+                            end++;
+                        }
+                    }
+                }
+                break;
+        }
     }
+
+    tok->current.type = type;
+    tok->current.offset = pos;
+    tok->current.length = end - pos;
+    tok->cursor = end;
+    return type;
 }
 
 bool _mytoml_tokenizer_load_input(Tokenizer *tok) {
     FILE *stream;
     if (tok->input.type == I_STREAM) {
+        // offsets into the input are kept in an `int`
+        if (tok->input.size >= MYTOML_MAX_FILE_SIZE) {
+            PARSE_ERR(tok, TOML_MEMORY, "input size is too big");
+            return false;
+        }
         return true;
     } else if (tok->input.type == I_FILE) {
         stream = tok->input.file.pointer;
     } else if (tok->input.type == I_File) {
-        stream = fopen(tok->input.file.name, "r");
+#if MYTOML_USE_MMAP
+        int fd = open(tok->input.file.name, O_RDONLY);
+        if (fd < 0) {
+            PARSE_ERR(tok, TOML_READ, "could not open input file");
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            if (st.st_size >= MYTOML_MAX_FILE_SIZE) {
+                PARSE_ERR(tok, TOML_READ, "input size is too big");
+                close(fd);
+                return false;
+            }
+            void *map = NULL;
+            if (st.st_size > 0) {
+                map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            if (map != MAP_FAILED) {
+                close(fd);
+                if (map != NULL) {
+                    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+                }
+                tok->input.stream = (const char *)map;
+                tok->input.size = (size_t)st.st_size;
+                tok->input.mapped = (map != NULL);
+                return true;
+            }
+        }
+        // not a regular file or it could not be mapped,
+        // fall back to reading it into a buffer
+        close(fd);
+#endif  // MYTOML_USE_MMAP
+        stream = fopen(tok->input.file.name, "rb");
+        if (stream == NULL) {
+            PARSE_ERR(tok, TOML_READ, "could not open input file");
+            return false;
+        }
     } else {
         stream = stdin;
     }
@@ -758,127 +2138,330 @@ bool _mytoml_tokenizer_load_input(Tokenizer *tok) {
     long size = ftell(stream);
     fseek(stream, 0L, SEEK_SET);
 
-    if (size >= MYTOML_MAX_FILE_SIZE) {
-        LOG_ERR("input size is too big\n");
-        return false;
+    bool ok = false;
+    char *buffer = NULL;
+    if (size < 0 || size >= MYTOML_MAX_FILE_SIZE) {
+        PARSE_ERR(tok, TOML_READ, "input size is too big");
+    } else if (size > 0 && (buffer = (char *)malloc(size)) == NULL) {
+        PARSE_ERR(tok, TOML_MEMORY, "could not allocate input buffer");
+    } else if (size > 0 && 1 != fread(buffer, size, 1, stream)) {
+        PARSE_ERR(tok, TOML_READ, "could not read input");
+        free(buffer);
+    } else {
+        tok->input.stream = buffer;
+        tok->input.size = (size_t)size;
+        tok->input.owned = true;
+        ok = true;
+    }
+    if (tok->input.type == I_File) {
+        fclose(stream);
     }
+    return ok;
+}
 
-    char *buffer = (char *)calloc(1, size + 1);
-    if (size > 0 && 1 != fread(buffer, size, 1, stream)) {
-        LOG_ERR("could not read input\n");
-        return false;
+void _mytoml_tokenizer_location(Tokenizer *tok, int offset, int *line, int *col) {
+    int pos = offset;
+    if ((size_t)pos > tok->input.size) pos = (int)tok->input.size;
+    int start = 0;
+    *line = 0;
+    for (int i = 0; i < pos; i++) {
+        if (tok->input.stream[i] == '\n') {
+            (*line)++;
+            start = i + 1;
+        }
     }
-    buffer[size] = EOF;
-    tok->input.stream = buffer;
-#undef MYTOML_MAX_FILE_SIZE
-    return true;
+    *col = pos - start;
+}
+
+void _mytoml_parser_error(Tokenizer *tok, TomlErrorType type, const char *message) {
+    if (tok->error.type != TOML_OK) return;
+    tok->error.type = type;
+    tok->error.message = message;
+    tok->error_offset = tok->current.offset;
 }
 
 bool _mytoml_tokenizer_has_token(Tokenizer *tok) { return tok->is_null; }
 
 char _mytoml_tokenizer_get_token(Tokenizer *tok) { return tok->token; }
 
-char _mytoml_tokenizer_get_previous_token(Tokenizer *tok) { return tok->prev; }
-
-char _mytoml_tokenizer_get_prev_prev_token(Tokenizer *tok) { return tok->prev_prev; }
-
 void _mytoml_tokenizer_delete(Tokenizer *tok) {
-    free(tok->input.stream);
+    if (tok->input.owned) {
+        free((char *)tok->input.stream);
+    }
+#if MYTOML_USE_MMAP
+    if (tok->input.mapped) {
+        munmap((void *)tok->input.stream, tok->input.size);
+    }
+#endif  // MYTOML_USE_MMAP
+    if (tok->pool.ids) kh_destroy(id, tok->pool.ids);
     free(tok);
 }
 
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Arena
+//-----------------------------------------------------------------------------
+
+// round `n` up so every allocation stays aligned for any scalar type
+#define MYTOML_ARENA_ALIGN(n) (((n) + 15) & ~(size_t)15)
+
+#define MYTOML_ARENA_DATA(c) ((char *)(c) + MYTOML_ARENA_ALIGN(sizeof(ArenaChunk)))
+
+TomlArena *_mytoml_arena_new(void) { return (TomlArena *)calloc(1, sizeof(TomlArena)); }
+
+void _mytoml_arena_delete(TomlArena *arena) {
+    if (!arena) return;
+    _mytoml_arena_delete(arena->next);
+    for (int i = 0; i < arena->len; i++) {
+        kh_destroy(index, arena->tables[i]);
+    }
+    free(arena->tables);
+    ArenaChunk *c = arena->chunk;
+    while (c) {
+        ArenaChunk *next = c->next;
+        free(c);
+        c = next;
+    }
+    free(arena);
+}
+
+void _mytoml_arena_adopt(TomlArena *arena, TomlArena *other) {
+    if (!other) return;
+    TomlArena *last = other;
+    while (last->next) last = last->next;
+    last->next = arena->next;
+    arena->next = other;
+}
+
+bool _mytoml_arena_track(TomlArena *arena, khash_t(index) *h) {
+    if (arena->len == arena->cap) {
+        int cap = (arena->cap > 0) ? arena->cap * 2 : 64;
+        khash_t(index) **tables = (khash_t(index) **)realloc(arena->tables, sizeof(khash_t(index) *) * cap);
+        if (tables == NULL) return false;
+        arena->tables = tables;
+        arena->cap = cap;
+    }
+    arena->tables[arena->len++] = h;
+    return true;
+}
+
+void *_mytoml_alloc(TomlArena *arena, size_t size) {
+    if (!arena) return calloc(1, size);
+    size = MYTOML_ARENA_ALIGN(size);
+    ArenaChunk *c = arena->chunk;
+    if (!c || c->size - c->used < size) {
+        size_t chunk = (size > MYTOML_ARENA_CHUNK_SIZE) ? size : MYTOML_ARENA_CHUNK_SIZE;
+        c = (ArenaChunk *)malloc(MYTOML_ARENA_ALIGN(sizeof(ArenaChunk)) + chunk);
+        if (c == NULL) return NULL;
+        c->next = arena->chunk;
+        c->size = chunk;
+        c->used = 0;
+        c->last = 0;
+        arena->chunk = c;
+    }
+    char *p = MYTOML_ARENA_DATA(c) + c->used;
+    c->last = c->used;
+    c->used += size;
+    memset(p, 0, size);
+    return p;
+}
+
+void *_mytoml_realloc(TomlArena *arena, void *p, size_t old, size_t size) {
+    if (!arena) return realloc(p, size);
+    if (!p) return _mytoml_alloc(arena, size);
+    ArenaChunk *c = arena->chunk;
+    // the last allocation of the current chunk can be resized in place
+    if ((char *)p == MYTOML_ARENA_DATA(c) + c->last && MYTOML_ARENA_ALIGN(size) <= c->size - c->last) {
+        c->used = c->last + MYTOML_ARENA_ALIGN(size);
+        return p;
+    }
+    if (size <= old) return p;
+    void *q = _mytoml_alloc(arena, size);
+    if (q) memcpy(q, p, old);
+    return q;
+}
+
+void _mytoml_free(TomlArena *arena, void *p) {
+    if (!arena) free(p);
+}
+
 //-----------------------------------------------------------------------------
 // [SECTION] Myjson Value
 //-----------------------------------------------------------------------------
 
-TomlValue *_mytoml_value_new_string(const char *s) {
-    TomlValue *v = (TomlValue *)calloc(1, sizeof(TomlValue));
+TomlValue *_mytoml_value_new_string(TomlArena *arena, char *s, int len) {
+    TomlValue *v = (TomlValue *)_mytoml_alloc(arena, sizeof(TomlValue));
+    if (v == NULL) return NULL;
     v->type = TOML_STRING;
-    v->data = calloc(1, strlen(s) + 1);
-    memcpy(v->data, s, strlen(s));
+    v->len = len;
+    v->str = s;
     return v;
 }
 
-TomlValue *_mytoml_value_new_number(double *d, TomlValueType type, size_t precision, bool scientific) {
-    TomlValue *v = (TomlValue *)calloc(1, sizeof(TomlValue));
+TomlValue *_mytoml_value_new_number(TomlArena *arena, double *d, TomlValueType type, size_t precision, bool scientific) {
+    TomlValue *v = (TomlValue *)_mytoml_alloc(arena, sizeof(TomlValue));
+    if (v == NULL) return NULL;
     v->type = type;
     v->scientific = scientific;
     v->precision = precision;
-    v->data = calloc(1, sizeof(double));
-    memcpy(v->data, d, sizeof(double));
+    if (type == TOML_BOOL) {
+        v->boolean = (*d != 0);
+    } else {
+        v->number = *d;
+    }
+    return v;
+}
+
+TomlValue *_mytoml_value_new_integer(TomlArena *arena, int64_t i) {
+    TomlValue *v = (TomlValue *)_mytoml_alloc(arena, sizeof(TomlValue));
+    if (v == NULL) return NULL;
+    v->type = TOML_INT;
+    v->integer = i;
     return v;
 }
 
-TomlValue *_mytoml_value_new_datetime(struct tm *dt, TomlValueType type, char *format, int millis) {
-    TomlValue *v = (TomlValue *)calloc(1, sizeof(TomlValue));
+TomlValue *_mytoml_value_new_datetime(TomlArena *arena, TomlDatetime *dt, TomlValueType type, int precision) {
+    TomlValue *v = (TomlValue *)_mytoml_alloc(arena, sizeof(TomlValue));
+    if (v == NULL) return NULL;
     v->type = type;
-    v->precision = millis;
-    v->data = calloc(1, sizeof(struct tm));
-    memset(v->format, 0, MYTOML_MAX_DATE_FORMAT);
-    if (strlen(format) < MYTOML_MAX_DATE_FORMAT) {
-        memcpy(v->format, format, strlen(format));
-    }
-    memcpy(v->data, dt, sizeof(struct tm));
+    v->precision = precision;
+    v->datetime = *dt;
     return v;
 }
 
-TomlValue *_mytoml_value_new_array() {
-    TomlValue *v = (TomlValue *)calloc(1, sizeof(TomlValue));
+TomlValue *_mytoml_value_new_array(TomlArena *arena) {
+    TomlValue *v = (TomlValue *)_mytoml_alloc(arena, sizeof(TomlValue));
+    if (v == NULL) return NULL;
     v->type = TOML_ARRAY;
-    v->arr = (TomlValue **)calloc(1, sizeof(TomlValue *) * MYTOML_MAX_ARRAY_LENGTH);
+    v->arr = NULL;
     v->len = 0;
+    v->cap = 0;
     return v;
 }
 
-TomlValue *_mytoml_value_new_table(TomlKey *k) {
-    TomlValue *v = (TomlValue *)calloc(1, sizeof(TomlValue));
-    v->type = TOML_INLINETABLE;
-    TomlKey *h = _mytoml_value_new_key(TOML_KEY);
-    for (khiter_t ki = kh_begin(k->subkeys); ki != kh_end(k->subkeys); ++ki) {
-        if (kh_exist(k->subkeys, ki)) {
-            _mytoml_value_add_sub_key(h, kh_value(k->subkeys, ki));
-        }
+bool _mytoml_value_array_push(TomlArena *arena, TomlValue *v, TomlValue *e) {
+    if (v->len == v->cap) {
+        int cap = (v->cap > 0) ? v->cap * 2 : MYTOML_ARRAY_INITIAL_CAPACITY;
+        TomlValue **arr = (TomlValue **)_mytoml_realloc(arena, v->arr, sizeof(TomlValue *) * v->cap, sizeof(TomlValue *) * cap);
+        if (arr == NULL) return false;
+        v->arr = arr;
+        v->cap = cap;
     }
-    v->data = h;
-    return v;
+    v->arr[v->len++] = e;
+    return true;
 }
 
-void _mytoml_value_delete(TomlValue *v) {
-    if (!v) return;
-    if (v->arr) {
-        for (TomlValue **iter = v->arr; *iter != NULL; iter++) {
-            _mytoml_value_delete(*iter);
-        }
-        free(v->arr);
+void _mytoml_value_array_shrink(TomlArena *arena, TomlValue *v) {
+    if (v->len == v->cap) return;
+    if (v->len == 0) {
+        _mytoml_free(arena, v->arr);
+        v->arr = NULL;
+        v->cap = 0;
+        return;
     }
-    if (v->data) {
-        free(v->data);
+    TomlValue **arr = (TomlValue **)_mytoml_realloc(arena, v->arr, sizeof(TomlValue *) * v->cap, sizeof(TomlValue *) * v->len);
+    if (arr != NULL) {
+        v->arr = arr;
+        v->cap = v->len;
     }
-    free(v);
 }
 
-//-----------------------------------------------------------------------------
-// [SECTION] Myjson Key
+TomlValue *_mytoml_value_new_table(TomlArena *arena, TomlKey *k) {
+    TomlValue *v = (TomlValue *)_mytoml_alloc(arena, sizeof(TomlValue));
+    if (v == NULL) return NULL;
+    v->type = TOML_INLINETABLE;
+    k->type = TOML_KEY;
+    v->table = k;
+    return v;
+}
+
+void _mytoml_value_delete(TomlArena *arena, TomlValue *v) {
+    // memory from an arena is released with the arena itself
+    if (!v || arena) return;
+    if (v->type == TOML_ARRAY) {
+        for (int i = 0; i < v->len; i++) {
+            _mytoml_value_delete(arena, v->arr[i]);
+        }
+        free(v->arr);
+    } else if (v->type == TOML_STRING) {
+        free(v->str);
+    } else if (v->type == TOML_INLINETABLE) {
+        _mytoml_value_delete_key(arena, v->table);
+    }
+    free(v);
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Key
 //-----------------------------------------------------------------------------
 
-TomlKey *_mytoml_value_new_key(TomlKeyType type) {
-    TomlKey *k = (TomlKey *)calloc(1, sizeof(TomlKey));
+TomlKey *_mytoml_value_new_key(TomlArena *arena, TomlKeyType type) {
+    TomlKey *k = (TomlKey *)_mytoml_alloc(arena, sizeof(TomlKey));
+    if (k == NULL) return NULL;
     k->type = type;
     k->value = NULL;
-    k->idx = -1;
-    k->subkeys = kh_init(str);
-    memset(k->id, 0, MYTOML_MAX_ID_LENGTH);
+    k->idx = TOML_KEY_NO_INDEX;
+    k->subkeys = (TomlTable){NULL, 0, 0, NULL};
+    k->id = _mytoml_empty_id.bytes;
     return k;
 }
 
 TomlKey *_mytoml_value_has_sub_key(TomlKey *key, TomlKey *subkey) {
-    khiter_t k = kh_get(str, key->subkeys, subkey->id);
-    if (k == kh_end(key->subkeys)) return NULL;
-    return kh_value(key->subkeys, k);
+    return _mytoml_value_find_sub_key(key, subkey->id, ID_LENGTH(subkey->id), ID_HASH(subkey->id));
+}
+
+#define ID_EQUAL(a, b, n) ((a) == (b) || (ID_LENGTH(a) == (n) && memcmp((a), (b), (n)) == 0))
+
+TomlKey *_mytoml_value_find_sub_key(TomlKey *key, const char *id, size_t length, khint_t hash) {
+    TomlTable *t = &key->subkeys;
+    khash_t(index) *h = (khash_t(index) *)t->index;
+    if (h == NULL) {
+        for (int i = 0; i < t->len; i++) {
+            if (t->entry[i].hash == hash && ID_EQUAL(t->entry[i].key->id, id, length)) return t->entry[i].key;
+        }
+        return NULL;
+    }
+    khint_t i = kh_get(index, h, ((IdSpan){id, (uint32_t)length, hash}));
+    return (i == kh_end(h)) ? NULL : kh_value(h, i);
+}
+
+static bool _mytoml_value_index_sub_key(khash_t(index) *h, TomlKey *subkey, khint_t hash) {
+    int ret;
+    khint_t i = kh_put(index, h, ((IdSpan){subkey->id, ID_LENGTH(subkey->id), hash}), &ret);
+    if (ret < 0) return false;
+    kh_value(h, i) = subkey;
+    return true;
+}
+
+bool _mytoml_value_put_sub_key(TomlArena *arena, TomlKey *key, TomlKey *subkey, khint_t hash) {
+    TomlTable *t = &key->subkeys;
+    if (t->len == t->cap) {
+        int cap = (t->cap > 0) ? t->cap * 2 : 4;
+        TomlEntry *entry = (TomlEntry *)_mytoml_realloc(arena, t->entry, sizeof(TomlEntry) * t->cap, sizeof(TomlEntry) * cap);
+        if (entry == NULL) return false;
+        t->entry = entry;
+        t->cap = cap;
+    }
+    t->entry[t->len++] = (TomlEntry){hash, subkey};
+    if (t->index != NULL) {
+        if (!_mytoml_value_index_sub_key((khash_t(index) *)t->index, subkey, hash)) return false;
+    } else if (t->len > MYTOML_TABLE_INDEX_THRESHOLD) {
+        khash_t(index) *h = kh_init(index);
+        if (h == NULL) return false;
+        if (arena && !_mytoml_arena_track(arena, h)) {
+            kh_destroy(index, h);
+            return false;
+        }
+        t->index = h;
+        for (int i = 0; i < t->len; i++) {
+            if (!_mytoml_value_index_sub_key(h, t->entry[i].key, t->entry[i].hash)) return false;
+        }
+    }
+    return true;
 }
 
-TomlKey *_mytoml_value_add_sub_key(TomlKey *key, TomlKey *subkey) {
-    TomlKey *s = _mytoml_value_has_sub_key(key, subkey);
+TomlKey *_mytoml_value_add_sub_key(TomlArena *arena, TomlKey *key, TomlKey *subkey) {
+    khint_t hash = ID_HASH(subkey->id);
+    TomlKey *s = _mytoml_value_find_sub_key(key, subkey->id, ID_LENGTH(subkey->id), hash);
     if (s) {
         if (_mytoml_value_keys_compatible(s->type, subkey->type)) {
             // re-defining a TABLE as a TABLELEAF
@@ -887,30 +2470,21 @@ TomlKey *_mytoml_value_add_sub_key(TomlKey *key, TomlKey *subkey) {
                 s->type = TOML_TABLELEAF;
             }
             return s;
-        } else {
-            RETURN_IF_FAILED(0,
-                             "failed to add subkey\n"
-                             "existing subkey - key: %s type: %d\n"
-                             "new subkey: key: %s type: %d\n",
-                             s->id, (int)(s->type), subkey->id, (int)(subkey->type));
         }
+        return NULL;
     }
-    if (kh_size(key->subkeys) < MYTOML_MAX_SUBKEYS) {
+    if (key->subkeys.len < MYTOML_MAX_SUBKEYS) {
         if (key->type == TOML_ARRAYTABLE) {
             // since an ARRAYTABLE is a list of a map of key-value,
             // and re-defining an ARRAYTABLE means adding another map
             // of key-value to the list, we use the `value->arr`
             // attribute of the key to store each map of key-values
-            TomlKey *a = _mytoml_value_add_sub_key((TomlKey *)key->value->arr[key->idx]->data, subkey);
+            TomlKey *a = _mytoml_value_add_sub_key(arena, key->value->arr[key->idx]->table, subkey);
             return a;
         } else {
-            int ret;
-            khiter_t k = kh_put(str, key->subkeys, subkey->id, &ret);
-            kh_value(key->subkeys, k) = subkey;
+            if (!_mytoml_value_put_sub_key(arena, key, subkey, hash)) return NULL;
             return subkey;
         }
-    } else {
-        LOG_ERR("buffer overflow\n");
     }
     return NULL;
 }
@@ -951,11 +2525,16 @@ bool _mytoml_value_keys_compatible(TomlKeyType existing, TomlKeyType current) {
     return false;
 }
 
-void _mytoml_value_delete_key(TomlKey *key) {
-    if (!key) return;
-    kh_destroy(str, key->subkeys);
+void _mytoml_value_delete_key(TomlArena *arena, TomlKey *key) {
+    // memory from an arena is released with the arena itself
+    if (!key || arena) return;
+    for (int i = 0; i < key->subkeys.len; i++) {
+        _mytoml_value_delete_key(arena, key->subkeys.entry[i].key);
+    }
+    free(key->subkeys.entry);
+    if (key->subkeys.index) kh_destroy(index, key->subkeys.index);
     if (key->value) {
-        _mytoml_value_delete(key->value);
+        _mytoml_value_delete(arena, key->value);
     }
     free(key);
 }
@@ -1006,11 +2585,19 @@ bool _mytoml_is_control_multi(char c) { return ((c >= 0x0 && c <= 0x8) || (c ==
 
 bool _mytoml_is_control_literal(char c) { return (((c != 0x9) && (c != 0xA) && (c >= 0x0 && c <= 0x1F)) || (c == 0x7F)); }
 
-bool _mytoml_is_number_end(char c, const char *end) {
-    for (size_t i = 0; i < strlen(end); i++) {
-        if (c == end[i]) return true;
+bool _mytoml_is_bare_value(char c) { return (_mytoml_is_bare_ascii(c) || c == '+' || c == '.' || c == ':'); }
+
+bool _mytoml_is_base_digit(char c, int base) {
+    switch (base) {
+        case 2:
+            return (c == '0' || c == '1');
+        case 8:
+            return (c >= '0' && c <= '7');
+        case 16:
+            return (_mytoml_is_digit(c) || _mytoml_is_hex_digit(c));
+        default:
+            return _mytoml_is_digit(c);
     }
-    return false;
 }
 
 bool _mytoml_is_decimal_point(char c) { return (c == '.'); }
@@ -1056,314 +2643,289 @@ bool _mytoml_is_date(int year, int month, int day) {
     return false;
 }
 
-bool _mytoml_is_valid_datetime(struct tm *datetime) {
-    return ((datetime->tm_hour >= 0 && datetime->tm_hour <= 23) && (datetime->tm_min >= 0 && datetime->tm_min <= 59) &&
-            (datetime->tm_sec >= 0 && datetime->tm_sec <= 59) && _mytoml_is_date(datetime->tm_year + 1900, datetime->tm_mon, datetime->tm_mday));
+#if MYTOML_SIMD_SSE2
+static inline int _mytoml_ctz(unsigned int mask) {
+#if MYTOML_COMPILER_IS(MSVC)
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (int)i;
+#else
+    return __builtin_ctz(mask);
+#endif
 }
-
-//-----------------------------------------------------------------------------
-// [SECTION] Myjson Parser Key
-//-----------------------------------------------------------------------------
-
-TomlKey *_mytoml_parser_bare_key(Tokenizer *tok, char end, TomlKeyType branch, TomlKeyType leaf) {
-    char id[MYTOML_MAX_ID_LENGTH] = {0};
-    int idx = 0;
-    bool done = false;
-
-    while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(idx < MYTOML_MAX_ID_LENGTH, "buffer overflow\n");
-        if (_mytoml_is_dot(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(idx != 0, "key cannot be empty\n");
-            TomlKey *subkey = _mytoml_value_new_key(branch);
-            memcpy(subkey->id, id, strlen(id));
-            return subkey;
-        } else if (_mytoml_tokenizer_get_token(tok) == end) {
-            RETURN_IF_FAILED(idx != 0, "key cannot be empty\n");
-            TomlKey *subkey = _mytoml_value_new_key(leaf);
-            memcpy(subkey->id, id, strlen(id));
-            return subkey;
-        } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-            // bare keys cannot contain whitespace inside each
-            // key, so we use the `done` variable to track it
-            done = true;
-            _mytoml_parser_parse_whitespace(tok);
-        } else if (_mytoml_is_bare_ascii(_mytoml_tokenizer_get_token(tok)) && !done) {
-            id[idx++] = _mytoml_tokenizer_get_token(tok);
-            _mytoml_tokenizer_next_token(tok);
-        } else {
-            LOG_ERR("unknown character %c\n", _mytoml_tokenizer_get_token(tok));
-            break;
-        }
+#endif  // MYTOML_SIMD_SSE2
+
+size_t _mytoml_scan_special(const char *s, size_t pos, size_t size, char a, char b) {
+#if MYTOML_SIMD_AVX2
+    const __m256i a32 = _mm256_set1_epi8(a);
+    const __m256i b32 = _mm256_set1_epi8(b);
+    const __m256i tab32 = _mm256_set1_epi8('\t');
+    const __m256i us32 = _mm256_set1_epi8(0x1F);
+    const __m256i del32 = _mm256_set1_epi8(0x7F);
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(s + pos));
+        // unsigned x <= 0x1F is max(x, 0x1F) == 0x1F
+        __m256i ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(x, tab32), _mm256_cmpeq_epi8(_mm256_max_epu8(x, us32), us32));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, a32), _mm256_cmpeq_epi8(x, b32)),
+                                    _mm256_or_si256(ctl, _mm256_cmpeq_epi8(x, del32)));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+        if (mask) return pos + _mytoml_ctz(mask);
     }
-    return NULL;
+#endif  // MYTOML_SIMD_AVX2
+#if MYTOML_SIMD_SSE2
+    const __m128i a16 = _mm_set1_epi8(a);
+    const __m128i b16 = _mm_set1_epi8(b);
+    const __m128i tab16 = _mm_set1_epi8('\t');
+    const __m128i us16 = _mm_set1_epi8(0x1F);
+    const __m128i del16 = _mm_set1_epi8(0x7F);
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(s + pos));
+        __m128i ctl = _mm_andnot_si128(_mm_cmpeq_epi8(x, tab16), _mm_cmpeq_epi8(_mm_max_epu8(x, us16), us16));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, a16), _mm_cmpeq_epi8(x, b16)), _mm_or_si128(ctl, _mm_cmpeq_epi8(x, del16)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(m);
+        if (mask) return pos + _mytoml_ctz(mask);
+    }
+#elif MYTOML_SIMD_NEON
+    const uint8x16_t a16 = vdupq_n_u8((uint8_t)a);
+    const uint8x16_t b16 = vdupq_n_u8((uint8_t)b);
+    const uint8x16_t tab16 = vdupq_n_u8('\t');
+    const uint8x16_t us16 = vdupq_n_u8(0x1F);
+    const uint8x16_t del16 = vdupq_n_u8(0x7F);
+    for (; pos + 16 <= size; pos += 16) {
+        uint8x16_t x = vld1q_u8((const uint8_t *)(s + pos));
+        uint8x16_t ctl = vbicq_u8(vcleq_u8(x, us16), vceqq_u8(x, tab16));
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(x, a16), vceqq_u8(x, b16)), vorrq_u8(ctl, vceqq_u8(x, del16)));
+        // narrow each byte of the mask to a nibble
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+        if (bits) return pos + (__builtin_ctzll(bits) >> 2);
+    }
+#endif  // MYTOML_SIMD_NEON
+    for (; pos < size; pos++) {
+        char c = s[pos];
+        if (c == a || c == b || (c != '\t' && (unsigned char)c < 0x20) || c == 0x7F) break;
+    }
+    return pos;
 }
 
-TomlKey *_mytoml_parser_basic_quoted_key(Tokenizer *tok, char end, TomlKeyType branch, TomlKeyType leaf) {
-    char id[MYTOML_MAX_ID_LENGTH] = {0};
-    int idx = 0;
+size_t _mytoml_scan_whitespace(const char *s, size_t pos, size_t size) {
+#if MYTOML_SIMD_AVX2
+    const __m256i sp32 = _mm256_set1_epi8(' ');
+    const __m256i tab32 = _mm256_set1_epi8('\t');
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(s + pos));
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(x, sp32), _mm256_cmpeq_epi8(x, tab32));
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(m);
+        if (mask) return pos + _mytoml_ctz(mask);
+    }
+#endif  // MYTOML_SIMD_AVX2
+#if MYTOML_SIMD_SSE2
+    const __m128i sp16 = _mm_set1_epi8(' ');
+    const __m128i tab16 = _mm_set1_epi8('\t');
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(s + pos));
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(x, sp16), _mm_cmpeq_epi8(x, tab16));
+        unsigned int mask = ~(unsigned int)_mm_movemask_epi8(m) & 0xFFFFu;
+        if (mask) return pos + _mytoml_ctz(mask);
+    }
+#elif MYTOML_SIMD_NEON
+    const uint8x16_t sp16 = vdupq_n_u8(' ');
+    const uint8x16_t tab16 = vdupq_n_u8('\t');
+    for (; pos + 16 <= size; pos += 16) {
+        uint8x16_t x = vld1q_u8((const uint8_t *)(s + pos));
+        uint8x16_t m = vmvnq_u8(vorrq_u8(vceqq_u8(x, sp16), vceqq_u8(x, tab16)));
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+        if (bits) return pos + (__builtin_ctzll(bits) >> 2);
+    }
+#endif  // MYTOML_SIMD_NEON
+    while (pos < size && _mytoml_is_whitesapce(s[pos])) pos++;
+    return pos;
+}
 
-    while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(idx < MYTOML_MAX_ID_LENGTH, "buffer overflow\n");
-        if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-                _mytoml_parser_parse_whitespace(tok);
+size_t _mytoml_scan_line(const char *s, size_t pos, size_t size, int *depth, char *quote) {
+    while (pos < size) {
+        char c = s[pos];
+        if (*quote) {
+            // multi-line strings are the only tokens spanning lines
+            pos = _mytoml_scan_special(s, pos, size, *quote, '\\');
+            if (pos >= size) break;
+            c = s[pos];
+            if (c == *quote && pos + 2 < size && s[pos + 1] == c && s[pos + 2] == c) {
+                // up to two more quotes are the last of the string
+                for (int extra = 0; extra < 2 && pos + 3 < size && s[pos + 3] == c; extra++) pos++;
+                *quote = 0;
+                pos += 3;
+            } else if (c == '\n') {
+                return pos + 1;
+            } else {
+                // a backslash ending the line still ends the line
+                pos += (c == '\\' && *quote == '"' && pos + 1 < size && s[pos + 1] != '\n') ? 2 : 1;
             }
-            if (_mytoml_is_dot(_mytoml_tokenizer_get_token(tok))) {
-                TomlKey *subkey = _mytoml_value_new_key(branch);
-                memcpy(subkey->id, id, strlen(id));
-                return subkey;
-            } else if (_mytoml_tokenizer_get_token(tok) == end) {
-                TomlKey *subkey = _mytoml_value_new_key(leaf);
-                memcpy(subkey->id, id, strlen(id));
-                return subkey;
+        } else if (c == '\n') {
+            return pos + 1;
+        } else if (c == '#') {
+            do pos = _mytoml_scan_special(s, pos + 1, size, '\n', '\n');
+            while (pos < size && s[pos] != '\n');
+        } else if (c == '"' || c == '\'') {
+            if (pos + 2 < size && s[pos + 1] == c && s[pos + 2] == c) {
+                *quote = c;
+                pos += 3;
+                continue;
             }
-            LOG_ERR("unknown character %c after end of key\n", _mytoml_tokenizer_get_token(tok));
-            break;
-        } else if (_mytoml_is_newline(_mytoml_tokenizer_get_token(tok))) {
-            LOG_ERR("unescaped newline while parsing key\n");
-            break;
-        } else if (_mytoml_is_escape(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            char escaped[5] = {0};
-            int c = _mytoml_parser_parse_escape(tok, escaped, 5);
-            RETURN_IF_FAILED(c != 0, "unknown escape sequence \\%c\n", _mytoml_tokenizer_get_token(tok));
-            RETURN_IF_FAILED(c < 5, "parsed escape sequence is too long\n");
-            for (int i = 0; i < c; i++) {
-                id[idx++] = escaped[i];
-                RETURN_IF_FAILED(idx < MYTOML_MAX_ID_LENGTH, "buffer overflow\n");
+            pos++;
+            while ((pos = _mytoml_scan_special(s, pos, size, c, '\\')) < size && s[pos] != '\n') {
+                if (s[pos] == c) {
+                    pos++;
+                    break;
+                }
+                pos += (s[pos] == '\\' && c == '"' && pos + 1 < size && s[pos + 1] != '\n') ? 2 : 1;
             }
-            // _mytoml_parser_parse_escape will parse everything and move on to the
-            // next token so we call _mytoml_tokenizer_backtrace here to offset the
-            // _mytoml_tokenizer_next_token call outside
-            _mytoml_tokenizer_backtrace(tok, 1);
-        } else if (_mytoml_is_control(_mytoml_tokenizer_get_token(tok))) {
-            LOG_ERR("control characters need to be escaped\n");
-            break;
         } else {
-            id[idx++] = _mytoml_tokenizer_get_token(tok);
+            // values spread over several lines are nested in brackets
+            if (c == '[' || c == '{') {
+                (*depth)++;
+            } else if ((c == ']' || c == '}') && *depth > 0) {
+                (*depth)--;
+            }
+            pos++;
         }
-        _mytoml_tokenizer_next_token(tok);
     }
-    return NULL;
+    return 0;
 }
 
-TomlKey *_mytoml_parser_literal_quoted_key(Tokenizer *tok, char end, TomlKeyType branch, TomlKeyType leaf) {
-    char id[MYTOML_MAX_ID_LENGTH] = {0};
-    int idx = 0;
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Parser Key
+//-----------------------------------------------------------------------------
 
-    while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(idx < MYTOML_MAX_ID_LENGTH, "buffer overflow\n");
-        if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-                _mytoml_parser_parse_whitespace(tok);
-            }
-            if (_mytoml_is_dot(_mytoml_tokenizer_get_token(tok))) {
-                TomlKey *subkey = _mytoml_value_new_key(branch);
-                memcpy(subkey->id, id, strlen(id));
-                return subkey;
-            } else if (_mytoml_tokenizer_get_token(tok) == end) {
-                TomlKey *subkey = _mytoml_value_new_key(leaf);
-                memcpy(subkey->id, id, strlen(id));
-                return subkey;
-            }
-            LOG_ERR("unknown character %c after end of key\n", _mytoml_tokenizer_get_token(tok));
-            break;
-        } else if (_mytoml_is_newline(_mytoml_tokenizer_get_token(tok))) {
-            LOG_ERR("unescaped newline while parsing key\n");
-            break;
-        } else if (_mytoml_is_control_literal(_mytoml_tokenizer_get_token(tok))) {
-            LOG_ERR("control characters need to be escaped\n");
-            break;
-        } else {
-            id[idx++] = _mytoml_tokenizer_get_token(tok);
+const char *_mytoml_parser_parse_key_id(Tokenizer *tok) {
+    const char *s = tok->input.stream + tok->current.offset;
+    int len = tok->current.length;
+    switch (tok->current.type) {
+        case T_BARE: {
+            return _mytoml_intern(&tok->pool, s, len);
         }
-        _mytoml_tokenizer_next_token(tok);
-    }
-    return NULL;
-}
-
-TomlKey *_mytoml_parser_parse_key(Tokenizer *tok, TomlKey *key, bool expecting) {
-    while (_mytoml_tokenizer_has_token(tok)) {
-        if (_mytoml_is_equal(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(!expecting, "found = while expecting a key\n");
-            _mytoml_tokenizer_next_token(tok);
-            return key;
-        } else if (_mytoml_is_dot(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(!expecting, "found . while expecting a key\n");
-            _mytoml_tokenizer_next_token(tok);
-            return _mytoml_parser_parse_key(tok, key, true);
-        } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_parser_parse_whitespace(tok);
-        } else if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            TomlKey *subkey = _mytoml_parser_basic_quoted_key(tok, '=', TOML_KEY, TOML_KEYLEAF);
-            RETURN_IF_FAILED(subkey, "failed to parse basic quoted key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add subkey to key %s\n", key->id);
-            return _mytoml_parser_parse_key(tok, subkey, false);
-        } else if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            TomlKey *subkey = _mytoml_parser_literal_quoted_key(tok, '=', TOML_KEY, TOML_KEYLEAF);
-            RETURN_IF_FAILED(subkey, "failed to parse literal quoted key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add subkey to key %s\n", key->id);
-            return _mytoml_parser_parse_key(tok, subkey, false);
-        } else {
-            TomlKey *subkey = _mytoml_parser_bare_key(tok, '=', TOML_KEY, TOML_KEYLEAF);
-            RETURN_IF_FAILED(subkey, "failed to parse bare key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add subkey to key %s\n", key->id);
-            return _mytoml_parser_parse_key(tok, subkey, false);
+        case T_BASIC_STRING:
+        case T_LITERAL_STRING: {
+            // the decoded key is never longer than the quoted one
+            char scratch[256];
+            char *id = (len - 1 <= (int)sizeof(scratch)) ? scratch : (char *)malloc(len - 1);
+            PARSE_IF_FAILED(tok, id, TOML_MEMORY, "could not allocate key");
+            int n = 0;
+            const char *interned = NULL;
+            if (_mytoml_parser_parse_string(tok, id, len - 1, &n)) interned = _mytoml_intern(&tok->pool, id, n);
+            if (id != scratch) free(id);
+            return interned;
         }
+        default:
+            PARSE_ERR(tok, TOML_DECODE, "expected a key");
+            break;
     }
     return NULL;
 }
 
-TomlKey *_mytoml_parser_parse_table(Tokenizer *tok, TomlKey *key, bool expecting) {
-    while (_mytoml_tokenizer_has_token(tok)) {
-        if (_mytoml_is_table_end(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(!expecting, "found ] while expecting a key\n");
-            _mytoml_tokenizer_next_token(tok);
-            return key;
-        } else if (_mytoml_is_dot(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(!expecting, "found . while expecting a key\n");
-            _mytoml_tokenizer_next_token(tok);
-            return _mytoml_parser_parse_table(tok, key, true);
-        } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_parser_parse_whitespace(tok);
-        } else if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            TomlKey *subkey = _mytoml_parser_basic_quoted_key(tok, ']', TOML_TABLE, TOML_TABLELEAF);
-            RETURN_IF_FAILED(subkey, "failed to parse basic quoted key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add key to subkey %s\n", key->id);
-            return _mytoml_parser_parse_table(tok, subkey, false);
-        } else if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            TomlKey *subkey = _mytoml_parser_literal_quoted_key(tok, ']', TOML_TABLE, TOML_TABLELEAF);
-            RETURN_IF_FAILED(subkey, "failed to parse literal quoted key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add key to subkey %s\n", key->id);
-            return _mytoml_parser_parse_table(tok, subkey, false);
-        } else {
-            TomlKey *subkey = _mytoml_parser_bare_key(tok, ']', TOML_TABLE, TOML_TABLELEAF);
-            RETURN_IF_FAILED(subkey, "failed to parse bare key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add key to subkey %s\n", key->id);
-            return _mytoml_parser_parse_table(tok, subkey, false);
+TomlKey *_mytoml_parser_parse_key(Tokenizer *tok, TomlKey *key, TomlKeyType branch, TomlKeyType leaf, TokenType end) {
+    while (tok->current.type != T_EOF) {
+        if (tok->current.type == T_WHITESPACE) {
+            _mytoml_lexer_next(tok, false);
         }
-    }
-    return NULL;
-}
-
-TomlKey *_mytoml_parser_parse_array_table(Tokenizer *tok, TomlKey *key, bool expecting) {
-    while (_mytoml_tokenizer_has_token(tok)) {
-        if (_mytoml_is_table_end(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(!expecting, "found ] while expecting a key\n");
-            _mytoml_tokenizer_next_token(tok);
-            RETURN_IF_FAILED(_mytoml_is_table_end(_mytoml_tokenizer_get_token(tok)), "found ] while expecting a key\n");
-            _mytoml_tokenizer_next_token(tok);
-            return key;
-        } else if (_mytoml_is_dot(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(!expecting, "found . while expecting a key\n");
-            _mytoml_tokenizer_next_token(tok);
-            return _mytoml_parser_parse_array_table(tok, key, true);
-        } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_parser_parse_whitespace(tok);
-        } else if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            TomlKey *subkey = _mytoml_parser_basic_quoted_key(tok, ']', TOML_TABLE, TOML_ARRAYTABLE);
-            RETURN_IF_FAILED(subkey, "failed to parse basic quoted key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add key to subkey %s\n", key->id);
-            return _mytoml_parser_parse_array_table(tok, subkey, false);
-        } else if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            TomlKey *subkey = _mytoml_parser_literal_quoted_key(tok, ']', TOML_TABLE, TOML_ARRAYTABLE);
-            RETURN_IF_FAILED(subkey, "failed to parse literal quoted key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add key to subkey %s\n", key->id);
-            return _mytoml_parser_parse_array_table(tok, subkey, false);
-        } else {
-            TomlKey *subkey = _mytoml_parser_bare_key(tok, ']', TOML_TABLE, TOML_ARRAYTABLE);
-            RETURN_IF_FAILED(subkey, "failed to parse bare key\n");
-            subkey = _mytoml_value_add_sub_key(key, subkey);
-            RETURN_IF_FAILED(subkey, "failed to add key to subkey %s\n", key->id);
-            return _mytoml_parser_parse_array_table(tok, subkey, false);
+        TomlKey *subkey = _mytoml_value_new_key(tok->arena, branch);
+        PARSE_IF_FAILED(tok, subkey, TOML_MEMORY, "failed to allocate key");
+        const char *id = _mytoml_parser_parse_key_id(tok);
+        FUNC_IF_FAILED(id, _mytoml_value_delete_key, tok->arena, subkey);
+        PARSE_IF_FAILED(tok, id, TOML_DECODE, "failed to parse key");
+        subkey->id = id;
+        if (_mytoml_lexer_next(tok, false) == T_WHITESPACE) {
+            _mytoml_lexer_next(tok, false);
+        }
+        if (tok->current.type == end) {
+            subkey->type = leaf;
+        } else if (tok->current.type != T_DOT) {
+            PARSE_ERR(tok, TOML_DECODE, "unexpected character after key");
+            _mytoml_value_delete_key(tok->arena, subkey);
+            return NULL;
         }
+        if (tok->continued && subkey->type == TOML_ARRAYTABLE && !_mytoml_parallel_continue(tok, key, id)) {
+            PARSE_ERR(tok, TOML_MEMORY, "could not continue array of tables");
+            _mytoml_value_delete_key(tok->arena, subkey);
+            return NULL;
+        }
+        TomlKey *k = _mytoml_value_add_sub_key(tok->arena, key, subkey);
+        // an existing subkey is returned when it is re-defined
+        if (k != subkey) _mytoml_value_delete_key(tok->arena, subkey);
+        if (k == NULL) {
+            TomlKey *owner = (key->type == TOML_ARRAYTABLE) ? key->value->arr[key->idx]->table : key;
+            PARSE_IF_FAILED(tok, !_mytoml_value_find_sub_key(owner, id, ID_LENGTH(id), ID_HASH(id)), KEY_ALREADY_EXISTS, "key is already defined");
+            PARSE_ERR(tok, TOML_MEMORY, "could not add key");
+            return NULL;
+        }
+        if (tok->current.type == end) {
+            return k;
+        }
+        _mytoml_lexer_next(tok, false);
+        key = k;
     }
     return NULL;
 }
 
 TomlKey *_mytoml_parser_parse_key_value(Tokenizer *tok, TomlKey *key, TomlKey *root) {
-    if (_mytoml_is_comment_start(_mytoml_tokenizer_get_token(tok))) {
-        bool ok = _mytoml_parser_parse_comment(tok);
-        RETURN_IF_FAILED(ok, "invalid comment\n");
-        return key;
-    } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-        _mytoml_parser_parse_whitespace(tok);
-        return key;
-    } else if (_mytoml_parser_parse_newline(tok)) {
-        _mytoml_tokenizer_next_token(tok);
-        return key;
-    } else if (_mytoml_is_table_start(_mytoml_tokenizer_get_token(tok))) {
-        _mytoml_tokenizer_next_token(tok);
-        TomlKey *table;
-        // [[ means we are parsing an arraytable
-        if (_mytoml_is_table_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            table = _mytoml_parser_parse_array_table(tok, root, true);
-            RETURN_IF_FAILED(table, "failed to parse array of tables\n");
+    switch (tok->current.type) {
+        case T_WHITESPACE:
+        case T_COMMENT:
+        case T_NEWLINE: {
+            _mytoml_lexer_next(tok, false);
+            return key;
+        }
+        case T_LBRACKET: {
+            _mytoml_lexer_next(tok, false);
+            TomlKey *table = _mytoml_parser_parse_key(tok, root, TOML_TABLE, TOML_TABLELEAF, T_RBRACKET);
+            PARSE_IF_FAILED(tok, table, TOML_DECODE, "failed to parse table");
+            _mytoml_lexer_next(tok, false);
+            PARSE_IF_FAILED(tok, _mytoml_parser_parse_line_end(tok), TOML_DECODE, "expected a newline after table");
+            return table;
+        }
+        case T_DLBRACKET: {
+            _mytoml_lexer_next(tok, false);
+            TomlKey *table = _mytoml_parser_parse_key(tok, root, TOML_TABLE, TOML_ARRAYTABLE, T_DRBRACKET);
+            PARSE_IF_FAILED(tok, table, TOML_DECODE, "failed to parse array of tables");
             // Since an arraytable is a map of key-value pairs, we
             // store it in the `value->arr` attribute of the `key`.
             // Each redefinition marks an new element in that array.
             // The key-value pairs are added to the `subkeys` of a
             // "pseudo" key that lives at `table->value->arr[ table->idx ].
             if (table->value == NULL) {
-                table->value = _mytoml_value_new_array();
+                table->value = _mytoml_value_new_array(tok->arena);
+                PARSE_IF_FAILED(tok, table->value, TOML_MEMORY, "failed to allocate array of tables");
             }
-            RETURN_IF_FAILED(table->idx < MYTOML_MAX_ARRAY_LENGTH - 1, "buffer overflow\n");
-            table->value->arr[++(table->idx)] = _mytoml_value_new_table(_mytoml_value_new_key(TOML_TABLE));
-        } else {
-            table = _mytoml_parser_parse_table(tok, root, true);
-            RETURN_IF_FAILED(table, "failed to parse table\n");
-        }
-        return table;
-    } else if (_mytoml_tokenizer_get_previous_token(tok) == '\0' || _mytoml_is_newline(_mytoml_tokenizer_get_previous_token(tok)) ||
-               // ignore white space found at the beginning of
-               // a line while parsing a key
-               (_mytoml_is_whitesapce(_mytoml_tokenizer_get_previous_token(tok)) && tok->newline)) {
-        TomlKey *subkey = _mytoml_parser_parse_key(tok, key, true);
-        RETURN_IF_FAILED(subkey, "failed to parse key\n");
-        TomlValue *v = _mytoml_parser_parse_value(tok, "# \n");
-        RETURN_IF_FAILED(v, "failed to parse value\n");
-        // If we parsed an inlinetable, to keep it in sync
-        // with our datastructure, we add the keys from the
-        // parsed key-value pairs as `subkeys` of the "active"
-        // `key`. Since the inline table is defined as
-        // `a = b`, the type would be a KEYLEAF. Since KEYLEAF
-        // re-definitions are not allowed, we "unlock" it as a
-        // KEY, add the `subkeys` and "lock" it again as a
-        // `KEYLEAF` to prevent re-definition.
-        if (v->type == TOML_INLINETABLE) {
-            TomlKey *h = (TomlKey *)(v->data);
-            subkey->type = TOML_KEY;
-            for (khiter_t ki = kh_begin(h->subkeys); ki != kh_end(h->subkeys); ++ki) {
-                if (kh_exist(h->subkeys, ki)) {
-                    TomlKey *e = _mytoml_value_add_sub_key(subkey, kh_value(h->subkeys, ki));
-                    RETURN_IF_FAILED(e, "could not add inline table key %s\n", kh_value(h->subkeys, ki)->id);
-                }
-            }
-            subkey->type = TOML_KEYLEAF;
-        } else {
-            subkey->value = v;
+            TomlKey *pseudo = _mytoml_value_new_key(tok->arena, TOML_KEY);
+            PARSE_IF_FAILED(tok, pseudo, TOML_MEMORY, "failed to allocate array of tables element");
+            TomlValue *element = _mytoml_value_new_table(tok->arena, pseudo);
+            FUNC_IF_FAILED(element, _mytoml_value_delete_key, tok->arena, pseudo);
+            PARSE_IF_FAILED(tok, element, TOML_MEMORY, "failed to allocate array of tables element");
+            bool ok = _mytoml_value_array_push(tok->arena, table->value, element);
+            FUNC_IF_FAILED(ok, _mytoml_value_delete, tok->arena, element);
+            PARSE_IF_FAILED(tok, ok, TOML_MEMORY, "failed to add array of tables element");
+            table->idx = table->value->len - 1;
+            _mytoml_lexer_next(tok, false);
+            PARSE_IF_FAILED(tok, _mytoml_parser_parse_line_end(tok), TOML_DECODE, "expected a newline after array of tables");
+            return table;
         }
-        _mytoml_parser_parse_whitespace(tok);
-        return key;
-    } else
-        LOG_ERR("unhandled character %c\n", _mytoml_tokenizer_get_token(tok));
+        case T_BARE:
+        case T_BASIC_STRING:
+        case T_LITERAL_STRING: {
+            TomlKey *subkey = _mytoml_parser_parse_key(tok, key, TOML_KEY, TOML_KEYLEAF, T_EQUAL);
+            PARSE_IF_FAILED(tok, subkey, TOML_DECODE, "failed to parse key");
+            _mytoml_lexer_next(tok, true);
+            PARSE_IF_FAILED(tok, _mytoml_parser_parse_leaf_value(tok, subkey), TOML_DECODE, "failed to parse value");
+            PARSE_IF_FAILED(tok, _mytoml_parser_parse_line_end(tok), TOML_DECODE, "expected a newline after value");
+            return key;
+        }
+        default:
+            break;
+    }
+    if (tok->current.type == T_EOF) {
+        PARSE_ERR(tok, TOML_DECODE, "unexpected end of input");
+    } else {
+        PARSE_ERR(tok, TOML_DECODE, "unexpected character");
+    }
     return NULL;
 }
 
@@ -1371,38 +2933,36 @@ TomlKey *_mytoml_parser_parse_key_value(Tokenizer *tok, TomlKey *key, TomlKey *r
 // [SECTION] Myjson Parser Value
 //-----------------------------------------------------------------------------
 
-char *_mytoml_parser_parse_basic_string(Tokenizer *tok, char *value, bool multi) {
+char *_mytoml_parser_parse_basic_string(Tokenizer *tok, char *value, int size, int *len, bool multi) {
     int idx = 0;
     while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
+        PARSE_IF_FAILED(tok, idx < size, TOML_DECODE, "buffer overflow");
         if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
             if (!multi) {
                 _mytoml_tokenizer_next_token(tok);
+                *len = idx;
                 return value;
-            } else {
-                int a = _mytoml_tokenizer_next_token(tok);
-                int b = _mytoml_tokenizer_next_token(tok);
-                if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok)) &&
-                    _mytoml_is_basic_string_start(_mytoml_tokenizer_get_previous_token(tok))) {
+            } else if (_mytoml_is_basic_string_start(_mytoml_tokenizer_peek(tok, 1)) && _mytoml_is_basic_string_start(_mytoml_tokenizer_peek(tok, 2))) {
+                _mytoml_tokenizer_next_token(tok);
+                _mytoml_tokenizer_next_token(tok);
+                _mytoml_tokenizer_next_token(tok);
+                // up to two quotes may come right before the delimiter
+                if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
+                    value[idx++] = '"';
                     _mytoml_tokenizer_next_token(tok);
-                    if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-                        value[idx++] = '"';
-                        _mytoml_tokenizer_next_token(tok);
-                    }
-                    RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
-                    if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-                        value[idx++] = '"';
-                        _mytoml_tokenizer_next_token(tok);
-                    }
-                    return value;
-                } else {
+                }
+                PARSE_IF_FAILED(tok, idx < size, TOML_DECODE, "buffer overflow");
+                if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
                     value[idx++] = '"';
-                    _mytoml_tokenizer_backtrace(tok, a + b - 1);
-                    continue;
+                    _mytoml_tokenizer_next_token(tok);
                 }
+                *len = idx;
+                return value;
+            } else {
+                value[idx++] = '"';
             }
         } else if (_mytoml_parser_parse_newline(tok) && !multi) {
-            LOG_ERR("newline before end of string\n");
+            PARSE_ERR(tok, TOML_DECODE, "newline before end of string");
             break;
         } else if (_mytoml_parser_parse_newline(tok) && multi && idx == 0)
             ;
@@ -1421,529 +2981,221 @@ char *_mytoml_parser_parse_basic_string(Tokenizer *tok, char *value, bool multi)
                         _mytoml_tokenizer_next_token(tok);
                     }
                 }
-                RETURN_IF_FAILED(hit, "cannot have characters on same line after \\\n");
+                PARSE_IF_FAILED(tok, hit, TOML_DECODE, "cannot have characters on same line after \\");
                 continue;
             } else {
-                RETURN_IF_FAILED(c != 0, "unknown escape sequence \\%c\n", _mytoml_tokenizer_get_token(tok));
-                RETURN_IF_FAILED(c < 5, "parsed escape sequence is too long\n");
+                PARSE_IF_FAILED(tok, c != 0, TOML_DECODE, "unknown escape sequence");
+                PARSE_IF_FAILED(tok, c < 5, TOML_DECODE, "parsed escape sequence is too long");
                 for (int i = 0; i < c; i++) {
                     value[idx++] = escaped[i];
-                    RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
+                    PARSE_IF_FAILED(tok, idx < size, TOML_DECODE, "buffer overflow");
                 }
-                // _mytoml_parser_parse_escape will parse everything and move on to the
-                // next token so we call _mytoml_tokenizer_backtrace here to offset the
-                // _mytoml_tokenizer_next_token call outside
-                _mytoml_tokenizer_backtrace(tok, 1);
+                // _mytoml_parser_parse_escape already moved on to the next token
+                continue;
             }
         } else if (!multi && _mytoml_is_control(_mytoml_tokenizer_get_token(tok))) {
-            LOG_ERR("control characters need to be escaped\n");
+            PARSE_ERR(tok, TOML_DECODE, "control characters need to be escaped");
             break;
         } else if (multi && _mytoml_is_control_multi(_mytoml_tokenizer_get_token(tok))) {
-            LOG_ERR("control characters need to be escaped\n");
+            PARSE_ERR(tok, TOML_DECODE, "control characters need to be escaped");
             break;
         } else {
-            value[idx++] = _mytoml_tokenizer_get_token(tok);
+            // copy the whole run of plain characters at once
+            int start = tok->cursor - 1;
+            int end = (int)_mytoml_scan_special(tok->input.stream, tok->cursor, tok->input.size, '"', '\\');
+            PARSE_IF_FAILED(tok, idx + end - start < size, TOML_DECODE, "buffer overflow");
+            memcpy(value + idx, tok->input.stream + start, end - start);
+            idx += end - start;
+            _mytoml_tokenizer_seek(tok, end);
+            continue;
         }
         _mytoml_tokenizer_next_token(tok);
     }
     return NULL;
 }
 
-char *_mytoml_parser_parse_literal_string(Tokenizer *tok, char *value, bool multi) {
+char *_mytoml_parser_parse_literal_string(Tokenizer *tok, char *value, int size, int *len, bool multi) {
     int idx = 0;
     while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
+        PARSE_IF_FAILED(tok, idx < size, TOML_DECODE, "buffer overflow");
         if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
             if (!multi) {
                 _mytoml_tokenizer_next_token(tok);
+                *len = idx;
                 return value;
-            } else {
-                int a = _mytoml_tokenizer_next_token(tok);
-                int b = _mytoml_tokenizer_next_token(tok);
-                if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok)) &&
-                    _mytoml_is_literal_string_start(_mytoml_tokenizer_get_previous_token(tok))) {
+            } else if (_mytoml_is_literal_string_start(_mytoml_tokenizer_peek(tok, 1)) && _mytoml_is_literal_string_start(_mytoml_tokenizer_peek(tok, 2))) {
+                _mytoml_tokenizer_next_token(tok);
+                _mytoml_tokenizer_next_token(tok);
+                _mytoml_tokenizer_next_token(tok);
+                // up to two quotes may come right before the delimiter
+                if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
+                    value[idx++] = '\'';
                     _mytoml_tokenizer_next_token(tok);
-                    if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-                        value[idx++] = '\'';
-                        _mytoml_tokenizer_next_token(tok);
-                    }
-                    RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
-                    if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-                        value[idx++] = '\'';
-                        _mytoml_tokenizer_next_token(tok);
-                    }
-                    return value;
-                } else {
+                }
+                PARSE_IF_FAILED(tok, idx < size, TOML_DECODE, "buffer overflow");
+                if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
                     value[idx++] = '\'';
-                    _mytoml_tokenizer_backtrace(tok, a + b - 1);
-                    continue;
+                    _mytoml_tokenizer_next_token(tok);
                 }
+                *len = idx;
+                return value;
+            } else {
+                value[idx++] = '\'';
             }
         } else if (_mytoml_parser_parse_newline(tok) && !multi) {
-            LOG_ERR("newline before end of string\n");
+            PARSE_ERR(tok, TOML_DECODE, "newline before end of string");
             break;
         } else if (_mytoml_parser_parse_newline(tok) && multi && idx == 0)
             ;
         else if (_mytoml_is_control_literal(_mytoml_tokenizer_get_token(tok))) {
-            LOG_ERR("control characters need to be escaped\n");
+            PARSE_ERR(tok, TOML_DECODE, "control characters need to be escaped");
             break;
         } else {
-            value[idx++] = _mytoml_tokenizer_get_token(tok);
+            // copy the whole run of plain characters at once
+            int start = tok->cursor - 1;
+            int end = (int)_mytoml_scan_special(tok->input.stream, tok->cursor, tok->input.size, '\'', '\'');
+            PARSE_IF_FAILED(tok, idx + end - start < size, TOML_DECODE, "buffer overflow");
+            memcpy(value + idx, tok->input.stream + start, end - start);
+            idx += end - start;
+            _mytoml_tokenizer_seek(tok, end);
+            continue;
         }
         _mytoml_tokenizer_next_token(tok);
     }
     return NULL;
 }
 
-Datetime *_mytoml_parser_parse_datetime(Tokenizer *tok, char *value, const char *num_end, struct tm *time) {
-    Datetime *dt = NULL;
-    int idx = 0;
-    // check to allow only 1 whitespace character
-    int spaces = 0;
-    while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
-        if ((_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok)) && spaces) ||
-            (!_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok)) && _mytoml_is_number_end(_mytoml_tokenizer_get_token(tok), num_end))) {
-            int millis = 0;
-            char year[5] = {0};
-            char mon[3] = {0};
-            char mday[3] = {0};
-            char hour[3] = {0};
-            char min[3] = {0};
-            char sec[3] = {0};
-            char delim[2] = {0};
-            char tz[2] = {0};
-            char off_s[2] = {0};
-            char off_h[3] = {0};
-            char off_m[3] = {0};
-
-            char *end;
-            unsigned long num;
-            int t;
-
-            // DATETIME with millisecond and offset
-            t = sscanf(value, "%4c-%2c-%2c%1c%2c:%2c:%2c.%d%1c%2c:%2c", year, mon, mday, delim, hour, min, sec, &millis, off_s, off_h, off_m);
-            if (t == 11) {
-                RETURN_IF_FAILED(strlen(delim) == 1, "invalid delimiter\n");
-                RETURN_IF_FAILED(strlen(off_s) == 1, "invalid offset sign\n");
-                RETURN_IF_FAILED((delim[0] == 'T' || delim[0] == 't' || delim[0] == ' '), "invalid delimiter\n");
-                RETURN_IF_FAILED((off_s[0] == '+' || off_s[0] == '-'), "invalid offset sign\n");
-
-                CHECK_DATE();
-                CHECK_TIME();
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified offset datetime is not valid\n");
-
-                CHECK_DATETIME(off_h, 2, "invalid offset hour\n");
-                RETURN_IF_FAILED((num >= 0Ul && num <= 23Ul), "invalid offset hour\n");
-                // TODO : Fix
-                //  time->tm_gmtoff = num * 60 * 60;
-                CHECK_DATETIME(off_m, 2, "invalid offset minute\n");
-                RETURN_IF_FAILED((num >= 0Ul && num <= 59Ul), "invalid offset minute\n");
-                // TODO : Fix
-                //  time->tm_gmtoff += num;
-
-                // TODO : Fix
-                // if (off_s[0] == '-')
-                // {
-                //     time->tm_gmtoff *= -1;
-                // }
-                if (delim[0] == ' ') {
-                    spaces = 0;
-                }
-
-                double mlen = floor(log10(abs(millis))) + 1;
-                if (mlen == 1) millis *= 100;
-                if (mlen == 2) millis *= 10;
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("YYYY-mm-DDTHH:MM:SS.-HH:MM") + mlen + spaces)),
-                                 "datetime has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_DATETIME;
-                dt->dt = time;
-                mlen = (mlen > 3) ? mlen : 3;
-                dt->millis = millis;
-                int sz = strlen("%Y-%m-%dT%H:%M:%S.-HH:MM") + mlen + 1;
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                snprintf(dt->format, sz, "%%Y-%%m-%%dT%%H:%%M:%%S.%d%c%s:%s", millis, off_s[0], off_h, off_m);
-                return dt;
-            }
-            // DATETIME with offset
-            t = sscanf(value, "%4c-%2c-%2c%1c%2c:%2c:%2c%1c%2c:%2c", year, mon, mday, delim, hour, min, sec, off_s, off_h, off_m);
-            if (t == 10) {
-                RETURN_IF_FAILED(strlen(delim) == 1, "invalid delimiter\n");
-                RETURN_IF_FAILED(strlen(off_s) == 1, "invalid offset sign\n");
-                RETURN_IF_FAILED((delim[0] == 'T' || delim[0] == 't' || delim[0] == ' '), "invalid delimiter\n");
-                RETURN_IF_FAILED((off_s[0] == '+' || off_s[0] == '-'), "invalid offset sign\n");
-
-                CHECK_DATE();
-                CHECK_TIME();
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified offset datetime is not valid\n");
-
-                CHECK_DATETIME(off_h, 2, "invalid offset hour\n");
-                RETURN_IF_FAILED((num >= 0 && num <= 23), "invalid offset hour\n");
-                // time->tm_gmtoff = num * 60 * 60;
-                CHECK_DATETIME(off_m, 2, "invalid offset minute\n");
-                RETURN_IF_FAILED((num >= 0 && num <= 59), "invalid offset minute\n");
-                // time->tm_gmtoff += num;
-
-                // if (off_s[0] == '-')
-                // {
-                //     time->tm_gmtoff *= -1;
-                // }
-                if (delim[0] == ' ') {
-                    spaces = 0;
-                }
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("YYYY-mm-DDTHH:MM:SS-HH:MM") + spaces)), "datetime has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_DATETIME;
-                dt->dt = time;
-                int sz = strlen("%Y-%m-%dT%H:%M:%S-HH:MM") + 1;
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                snprintf(dt->format, sz, "%%Y-%%m-%%dT%%H:%%M:%%S%c%s:%s", off_s[0], off_h, off_m);
-                return dt;
-            }
-            // DATETIME with millisecond and timezone
-            t = sscanf(value, "%4c-%2c-%2c%1c%2c:%2c:%2c.%d%1c", year, mon, mday, delim, hour, min, sec, &millis, tz);
-            if (t == 9) {
-                RETURN_IF_FAILED(strlen(delim) == 1, "invalid delimiter\n");
-                RETURN_IF_FAILED(strlen(tz) == 1, "invalid timezone\n");
-                RETURN_IF_FAILED((delim[0] == 'T' || delim[0] == 't' || delim[0] == ' '), "invalid delimiter\n");
-                RETURN_IF_FAILED((tz[0] == 'Z' || tz[0] == 'z'), "invalid timezone\n");
-
-                CHECK_DATE();
-                CHECK_TIME();
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified offset datetime is not valid\n");
-
-                // time->tm_zone = "UTC";
-
-                if (delim[0] == ' ') {
-                    spaces = 0;
-                }
-
-                double mlen = floor(log10(abs(millis))) + 1;
-                if (mlen == 1) millis *= 100;
-                if (mlen == 2) millis *= 10;
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("YYYY-mm-DDTHH:MM:SS.Z") + mlen + spaces)),
-                                 "datetime has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_DATETIME;
-                dt->dt = time;
-                mlen = (mlen > 3) ? mlen : 3;
-                dt->millis = millis;
-                int sz = strlen("%Y-%m-%dT%H:%M:%S.Z") + mlen + 1;
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                snprintf(dt->format, sz, "%%Y-%%m-%%dT%%H:%%M:%%S.%dZ", millis);
-                return dt;
-            }
-            // DATETIMELOCAL with millisecond
-            t = sscanf(value, "%4c-%2c-%2c%1c%2c:%2c:%2c.%d", year, mon, mday, delim, hour, min, sec, &millis);
-            if (t == 8) {
-                RETURN_IF_FAILED(strlen(delim) == 1, "invalid delimiter\n");
-                RETURN_IF_FAILED((delim[0] == 'T' || delim[0] == 't' || delim[0] == ' '), "invalid delimiter\n");
-
-                CHECK_DATE();
-                CHECK_TIME();
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified local datetime is not valid\n");
-
-                if (delim[0] == ' ') {
-                    spaces = 0;
-                }
-
-                double mlen = floor(log10(abs(millis))) + 1;
-                if (mlen == 1) millis *= 100;
-                if (mlen == 2) millis *= 10;
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("YYYY-mm-DDTHH:MM:SS.") + mlen + spaces)),
-                                 "datetime has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_DATETIMELOCAL;
-                dt->dt = time;
-                mlen = (mlen > 3) ? mlen : 3;
-                dt->millis = millis;
-                int sz = strlen("%Y-%m-%dT%H:%M:%S.") + mlen + 1;
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                snprintf(dt->format, sz, "%%Y-%%m-%%dT%%H:%%M:%%S.%d", millis);
-                return dt;
-            }
-            // DATETIME with timezone
-            t = sscanf(value, "%4c-%2c-%2c%1c%2c:%2c:%2c%1c", year, mon, mday, delim, hour, min, sec, tz);
-            if (t == 8) {
-                RETURN_IF_FAILED(strlen(delim) == 1, "invalid delimiter\n");
-                RETURN_IF_FAILED(strlen(tz) == 1, "invalid timezone\n");
-                RETURN_IF_FAILED((delim[0] == 'T' || delim[0] == 't' || delim[0] == ' '), "invalid delimiter\n");
-                RETURN_IF_FAILED((tz[0] == 'Z' || tz[0] == 'z'), "invalid timezone\n");
-
-                CHECK_DATE();
-                CHECK_TIME();
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified offset datetime is not valid\n");
-
-                // time->tm_zone = "UTC";
-
-                if (delim[0] == ' ') {
-                    spaces = 0;
-                }
-
-                double mlen = floor(log10(abs(millis))) + 1;
-                if (mlen == 1) millis *= 100;
-                if (mlen == 2) millis *= 10;
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("YYYY-mm-DDTHH:MM:SSZ") + spaces)), "datetime has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_DATETIME;
-                dt->dt = time;
-                int sz = strlen("%Y-%m-%dT%H:%M:%SZ") + 1;
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                snprintf(dt->format, sz, "%%Y-%%m-%%dT%%H:%%M:%%SZ");
-                return dt;
-            }
-            // DATETIMELOCAL
-            t = sscanf(value, "%4c-%2c-%2c%1c%2c:%2c:%2c", year, mon, mday, delim, hour, min, sec);
-            if (t == 7) {
-                RETURN_IF_FAILED(strlen(delim) == 1, "invalid delimiter\n");
-                RETURN_IF_FAILED((delim[0] == 'T' || delim[0] == 't' || delim[0] == ' '), "invalid delimiter\n");
-
-                CHECK_DATE();
-                CHECK_TIME();
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified local datetime is not valid\n");
-
-                if (delim[0] == ' ') {
-                    spaces = 0;
-                }
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("YYYY-mm-DDTHH:MM:SS") + spaces)), "datetime has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_DATETIMELOCAL;
-                dt->dt = time;
-                int sz = strlen("%Y-%m-%dT%H:%M:%S");
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                memcpy(dt->format, "%Y-%m-%dT%H:%M:%S", sz);
-                return dt;
-            }
-            // DATELOCAL
-            t = sscanf(value, "%4c-%2c-%2c", year, mon, mday);
-            if (t == 3) {
-                CHECK_DATE();
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified local date is not valid\n");
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("YYYY-mm-DD") + spaces)), "date has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_DATELOCAL;
-                dt->dt = time;
-                int sz = strlen("%Y-%m-%d");
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                memcpy(dt->format, "%Y-%m-%d", sz);
-                return dt;
-            }
-            // TIMELOCAL with millisecond
-            t = sscanf(value, "%2c:%2c:%2c.%d", hour, min, sec, &millis);
-            if (t == 4) {
-                CHECK_TIME();
-                time->tm_year = 0;
-                time->tm_mon = 0;
-                time->tm_mday = 1;
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified local time is not valid\n");
-
-                double mlen = floor(log10(abs(millis))) + 1;
-                if (mlen == 1) millis *= 100;
-                if (mlen == 2) millis *= 10;
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("HH:MM:SS.") + mlen + spaces)), "time has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_TIMELOCAL;
-                dt->dt = time;
-                mlen = (mlen > 3) ? mlen : 3;
-                dt->millis = millis;
-                int sz = strlen("%H:%M:%S.") + mlen + 1;
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                snprintf(dt->format, sz, "%%H:%%M:%%S.%d", millis);
-                return dt;
-            }
-            // TIMELOCAL
-            t = sscanf(value, "%2c:%2c:%2c", hour, min, sec);
-            if (t == 3) {
-                CHECK_TIME();
-                time->tm_year = 0;
-                time->tm_mon = 0;
-                time->tm_mday = 1;
-                RETURN_IF_FAILED(_mytoml_is_valid_datetime(time), "specified local time is not valid\n");
-
-                RETURN_IF_FAILED((strlen(value) == (strlen("HH:MM:SS") + spaces)), "time has incorrect number of characters\n");
-
-                dt = (Datetime *)calloc(1, sizeof(Datetime));
-                dt->type = TOML_TIMELOCAL;
-                dt->dt = time;
-                int sz = strlen("%H:%M:%S");
-                FUNC_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, free, dt);
-                RETURN_IF_FAILED(sz < MYTOML_MAX_DATE_FORMAT, "datetime string is too long");
-                memcpy(dt->format, "%H:%M:%S", sz);
-                return dt;
-            }
-#undef CHECK_TIME
-#undef CHECK_DATE
-#undef CHECK_DATETIME
-            LOG_ERR("could not parse %s as datetime\n", value);
-            break;
-        } else {
-            if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-                spaces++;
-            }
-            value[idx++] = _mytoml_tokenizer_get_token(tok);
-        }
-        _mytoml_tokenizer_next_token(tok);
+int _mytoml_parser_parse_fixed(const char *s, int n) {
+    int num = 0;
+    for (int i = 0; i < n; i++) {
+        if (!_mytoml_is_digit(s[i])) return -1;
+        num = num * 10 + (s[i] - '0');
     }
-    return NULL;
+    return num;
 }
 
-double _mytoml_parser_parse_lnf_nan(Tokenizer *tok, bool negative) {
-    double ret = 0.0;
-    if (_mytoml_tokenizer_get_token(tok) == 'i') {
-        _mytoml_tokenizer_next_token(tok);
-        _mytoml_tokenizer_next_token(tok);
-        if (_mytoml_tokenizer_get_previous_token(tok) == 'n' && _mytoml_tokenizer_get_token(tok) == 'f') {
-            if (negative) {
-                ret = (double)-INFINITY;
-            } else {
-                ret = (double)INFINITY;
-            }
+Datetime *_mytoml_parser_parse_datetime(const char *s, int len, Datetime *dt) {
+    memset(dt, 0, sizeof(Datetime));
+    TomlDatetime *v = &dt->value;
+    int i = 0;
+    bool date = (len >= 10 && s[4] == '-' && s[7] == '-');
+    if (date) {
+        int year = _mytoml_parser_parse_fixed(s, 4);
+        int month = _mytoml_parser_parse_fixed(s + 5, 2);
+        int day = _mytoml_parser_parse_fixed(s + 8, 2);
+        if (year < 0 || month < 0 || day < 0) return NULL;
+        if (!_mytoml_is_date(year, month - 1, day)) return NULL;
+        v->year = year;
+        v->month = month;
+        v->day = day;
+        if (len == 10) {
+            dt->type = TOML_DATELOCAL;
+            return dt;
         }
+        if (s[10] != 'T' && s[10] != 't' && s[10] != ' ') return NULL;
+        i = 11;
     }
-    if (_mytoml_tokenizer_get_token(tok) == 'n') {
-        _mytoml_tokenizer_next_token(tok);
-        _mytoml_tokenizer_next_token(tok);
-        if (_mytoml_tokenizer_get_previous_token(tok) == 'a' && _mytoml_tokenizer_get_token(tok) == 'n') {
-            if (negative) {
-                ret = (double)-NAN;
-            } else {
-                ret = (double)NAN;
-            }
+    if (len < i + 8 || s[i + 2] != ':' || s[i + 5] != ':') return NULL;
+    int hour = _mytoml_parser_parse_fixed(s + i, 2);
+    int minute = _mytoml_parser_parse_fixed(s + i + 3, 2);
+    int second = _mytoml_parser_parse_fixed(s + i + 6, 2);
+    if (hour < 0 || hour > 23) return NULL;
+    if (minute < 0 || minute > 59) return NULL;
+    // 60 is a leap second
+    if (second < 0 || second > 60) return NULL;
+    v->hour = hour;
+    v->minute = minute;
+    v->second = second;
+    i += 8;
+    if (i < len && s[i] == '.') {
+        int digits = 0;
+        for (i++; i < len && _mytoml_is_digit(s[i]); i++, digits++) {
+            // only nanoseconds are kept
+            if (digits < 9) v->nanosecond = v->nanosecond * 10 + (s[i] - '0');
         }
+        if (digits == 0) return NULL;
+        for (int d = digits; d < 9; d++) v->nanosecond *= 10;
+        dt->precision = (digits > 9) ? 9 : digits;
     }
-    _mytoml_tokenizer_next_token(tok);
-    return ret;
+    if (!date) {
+        if (i != len) return NULL;
+        dt->type = TOML_TIMELOCAL;
+        return dt;
+    }
+    if (i == len) {
+        dt->type = TOML_DATETIMELOCAL;
+        return dt;
+    }
+    dt->type = TOML_DATETIME;
+    if (s[i] == 'Z' || s[i] == 'z') {
+        if (i + 1 != len) return NULL;
+        v->flags |= TOML_DATETIME_ZULU;
+        return dt;
+    }
+    if ((s[i] != '+' && s[i] != '-') || len != i + 6 || s[i + 3] != ':') return NULL;
+    int offset_hour = _mytoml_parser_parse_fixed(s + i + 1, 2);
+    int offset_minute = _mytoml_parser_parse_fixed(s + i + 4, 2);
+    if (offset_hour < 0 || offset_hour > 23) return NULL;
+    if (offset_minute < 0 || offset_minute > 59) return NULL;
+    v->offset = offset_hour * 60 + offset_minute;
+    if (s[i] == '-') v->offset = -v->offset;
+    return dt;
 }
 
 TomlValue *_mytoml_parser_parse_array(Tokenizer *tok, TomlValue *arr) {
     bool sep = true;
-    while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(arr->len < MYTOML_MAX_ARRAY_LENGTH, "buffer overflow\n");
-        if (_mytoml_is_array_end(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            return arr;
-        } else if (_mytoml_is_array_seperator(_mytoml_tokenizer_get_token(tok))) {
-            RETURN_IF_FAILED(!sep, "expected value but got , instead\n");
-            sep = true;
-            _mytoml_tokenizer_next_token(tok);
-        } else if (_mytoml_parser_parse_newline(tok)) {
-            _mytoml_tokenizer_next_token(tok);
-        } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_parser_parse_whitespace(tok);
-        } else if (_mytoml_is_comment_start(_mytoml_tokenizer_get_token(tok))) {
-            bool ok = _mytoml_parser_parse_comment(tok);
-            RETURN_IF_FAILED(ok, "invalid comment\n");
-        } else {
-            RETURN_IF_FAILED(sep, "expected , between elements\n");
-            TomlValue *v = _mytoml_parser_parse_value(tok, "#,] \n");
-            RETURN_IF_FAILED(v, "could not parse value\n");
-            arr->arr[arr->len++] = v;
-            sep = false;
-        }
-    }
-    return NULL;
-}
-
-double _mytoml_parser_parse_boolean(Tokenizer *tok) {
-    double ret = 2.0;
-    if (_mytoml_tokenizer_get_token(tok) == 't') {
-        _mytoml_tokenizer_next_token(tok);
-        _mytoml_tokenizer_next_token(tok);
-        _mytoml_tokenizer_next_token(tok);
-        if (_mytoml_tokenizer_get_prev_prev_token(tok) != 'r' || _mytoml_tokenizer_get_previous_token(tok) != 'u' ||
-            _mytoml_tokenizer_get_token(tok) != 'e') {
-            ret = 2.0;
-        } else {
-            ret = 1.0;
-        }
-    } else if (_mytoml_tokenizer_get_token(tok) == 'f') {
-        _mytoml_tokenizer_next_token(tok);
-        _mytoml_tokenizer_next_token(tok);
-        _mytoml_tokenizer_next_token(tok);
-        if (_mytoml_tokenizer_get_prev_prev_token(tok) != 'a' || _mytoml_tokenizer_get_previous_token(tok) != 'l' ||
-            _mytoml_tokenizer_get_token(tok) != 's') {
-            ret = 2.0;
-        } else {
-            _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_tokenizer_get_token(tok) == 'e') {
-                ret = 0.0;
+    while (tok->current.type != T_EOF) {
+        switch (tok->current.type) {
+            case T_RBRACKET:
+                _mytoml_value_array_shrink(tok->arena, arr);
+                return arr;
+            case T_COMMA:
+                PARSE_IF_FAILED(tok, !sep, TOML_DECODE, "expected value but got , instead");
+                sep = true;
+                _mytoml_lexer_next(tok, true);
+                break;
+            case T_NEWLINE:
+            case T_WHITESPACE:
+            case T_COMMENT:
+                _mytoml_lexer_next(tok, true);
+                break;
+            default: {
+                PARSE_IF_FAILED(tok, sep, MISSING_SEPARATOR, "expected , between elements");
+                TomlValue *v = _mytoml_parser_parse_value(tok);
+                PARSE_IF_FAILED(tok, v, TOML_DECODE, "could not parse value");
+                bool ok = _mytoml_value_array_push(tok->arena, arr, v);
+                FUNC_IF_FAILED(ok, _mytoml_value_delete, tok->arena, v);
+                PARSE_IF_FAILED(tok, ok, TOML_MEMORY, "could not add value to array");
+                sep = false;
+                break;
             }
         }
     }
-    _mytoml_tokenizer_next_token(tok);
-    return ret;
+    return NULL;
 }
 
-TomlKey *_mytoml_parser_parse_inline_tabel(Tokenizer *tok) {
-    TomlKey *keys = _mytoml_value_new_key(TOML_TABLE);
+TomlKey *_mytoml_parser_parse_inline_tabel(Tokenizer *tok, TomlKey *owner) {
     bool sep = true;
     bool first = true;
-    while (_mytoml_tokenizer_has_token(tok)) {
-        if (_mytoml_is_inline_table_end(_mytoml_tokenizer_get_token(tok))) {
-            FUNC_IF_FAILED((!sep || first), _mytoml_value_delete_key, keys);
-            RETURN_IF_FAILED((!sep || first), "cannot have trailing comma in inline table\n");
-            _mytoml_tokenizer_next_token(tok);
-            return keys;
-        } else if (_mytoml_is_inline_table_seperator(_mytoml_tokenizer_get_token(tok))) {
-            FUNC_IF_FAILED(!sep, _mytoml_value_delete_key, keys);
-            RETURN_IF_FAILED(!sep, "expected key-value but got , instead");
+    while (tok->current.type != T_EOF) {
+        if (tok->current.type == T_RBRACE) {
+            PARSE_IF_FAILED(tok, (!sep || first), TOML_DECODE, "cannot have trailing comma in inline table");
+            return owner;
+        } else if (tok->current.type == T_COMMA) {
+            PARSE_IF_FAILED(tok, !sep, TOML_DECODE, "expected key-value but got , instead");
             sep = true;
-            _mytoml_tokenizer_next_token(tok);
-        } else if (_mytoml_parser_parse_newline(tok)) {
-            LOG_ERR("found newline in inline table\n");
+            _mytoml_lexer_next(tok, false);
+        } else if (tok->current.type == T_NEWLINE) {
+            PARSE_ERR(tok, TOML_DECODE, "found newline in inline table");
             break;
-        } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_parser_parse_whitespace(tok);
+        } else if (tok->current.type == T_WHITESPACE) {
+            _mytoml_lexer_next(tok, false);
         } else {
-            FUNC_IF_FAILED(sep, _mytoml_value_delete_key, keys);
-            RETURN_IF_FAILED(sep, "expected , between elements\n");
-            TomlKey *k = _mytoml_parser_parse_key(tok, keys, true);
-            FUNC_IF_FAILED(k, _mytoml_value_delete_key, keys);
-            RETURN_IF_FAILED(k, "failed to parse key\n");
-            TomlValue *v = _mytoml_parser_parse_value(tok, ", }");
-            FUNC_IF_FAILED(v, _mytoml_value_delete_key, keys);
-            RETURN_IF_FAILED(v, "failed to parse value\n");
-            // refer to inline table comment in `keys.c`
-            if (v->type == TOML_INLINETABLE) {
-                TomlKey *h = (TomlKey *)(v->data);
-                k->type = TOML_KEY;
-                for (khiter_t ki = kh_begin(h->subkeys); ki != kh_end(h->subkeys); ++ki) {
-                    if (kh_exist(h->subkeys, ki)) {
-                        TomlKey *e = _mytoml_value_add_sub_key(k, kh_value(h->subkeys, ki));
-                        FUNC_IF_FAILED(e, _mytoml_value_delete_key, keys);
-                        RETURN_IF_FAILED(e, "could not add inline table key %s\n", kh_value(h->subkeys, ki)->id);
-                    }
-                }
-                k->type = TOML_KEYLEAF;
-            } else {
-                k->value = v;
-            }
-            _mytoml_parser_parse_whitespace(tok);
+            PARSE_IF_FAILED(tok, sep, MISSING_SEPARATOR, "expected , between elements");
+            TomlKey *k = _mytoml_parser_parse_key(tok, owner, TOML_KEY, TOML_KEYLEAF, T_EQUAL);
+            PARSE_IF_FAILED(tok, k, TOML_DECODE, "failed to parse key");
+            _mytoml_lexer_next(tok, true);
+            PARSE_IF_FAILED(tok, _mytoml_parser_parse_leaf_value(tok, k), TOML_DECODE, "failed to parse value");
             sep = false;
             first = false;
         }
@@ -1951,17 +3203,24 @@ TomlKey *_mytoml_parser_parse_inline_tabel(Tokenizer *tok) {
     return NULL;
 }
 
-bool _mytoml_parser_parse_comment(Tokenizer *tok) {
-    while (_mytoml_tokenizer_has_token(tok)) {
-        _mytoml_tokenizer_next_token(tok);
-        if (_mytoml_parser_parse_newline(tok)) {
-            _mytoml_tokenizer_next_token(tok);
-            return true;
-        }
-        if (_mytoml_is_control(_mytoml_tokenizer_get_token(tok))) {
-            return false;
-        }
+bool _mytoml_parser_parse_leaf_value(Tokenizer *tok, TomlKey *leaf) {
+    if (tok->current.type == T_WHITESPACE) {
+        _mytoml_lexer_next(tok, true);
     }
+    if (tok->current.type != T_LBRACE) {
+        leaf->value = _mytoml_parser_parse_value(tok);
+        return leaf->value != NULL;
+    }
+    // An inline table `a = {b = c}` is parsed straight into the
+    // `subkeys` of its KEYLEAF. Since KEYLEAF re-definitions are
+    // not allowed, we "unlock" it as a KEY while its pairs are
+    // added and "lock" it again as a KEYLEAF afterwards.
+    _mytoml_lexer_next(tok, false);
+    leaf->type = TOML_KEY;
+    TomlKey *k = _mytoml_parser_parse_inline_tabel(tok, leaf);
+    leaf->type = TOML_KEYLEAF;
+    PARSE_IF_FAILED(tok, k, TOML_DECODE, "could not parse inline table");
+    _mytoml_lexer_next(tok, true);
     return true;
 }
 
@@ -1977,23 +3236,35 @@ void _mytoml_parser_parse_whitespace(Tokenizer *tok) {
 bool _mytoml_parser_parse_newline(Tokenizer *tok) {
     if (_mytoml_is_newline(_mytoml_tokenizer_get_token(tok))) {
         return true;
-    } else if (_mytoml_is_return(_mytoml_tokenizer_get_token(tok))) {
-        bool a = _mytoml_tokenizer_next_token(tok);
-        if (_mytoml_is_newline(_mytoml_tokenizer_get_token(tok))) {
-            return true;
-        } else {
-            _mytoml_tokenizer_backtrace(tok, a);
-        }
+    } else if (_mytoml_is_return(_mytoml_tokenizer_get_token(tok)) && _mytoml_is_newline(_mytoml_tokenizer_peek(tok, 1))) {
+        // leave `token` on the `\n` of the CRLF
+        _mytoml_tokenizer_next_token(tok);
+        return true;
     }
     return false;
 }
 
+bool _mytoml_parser_parse_line_end(Tokenizer *tok) {
+    if (tok->current.type == T_WHITESPACE) {
+        _mytoml_lexer_next(tok, false);
+    }
+    if (tok->current.type == T_COMMENT) {
+        _mytoml_lexer_next(tok, false);
+    }
+    if (tok->current.type == T_NEWLINE) {
+        _mytoml_lexer_next(tok, false);
+        return true;
+    }
+    return tok->current.type == T_EOF;
+}
+
+
 int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len) {
     int digits = 0;
     char code[9] = {0};
     while (_mytoml_tokenizer_has_token(tok)) {
         if (digits > 8) {
-            LOG_ERR("Invalid unicode escape code\n");
+            PARSE_ERR(tok, TOML_DECODE, "invalid unicode escape code");
             break;
         }
         if (_mytoml_is_hex_digit(_mytoml_tokenizer_get_token(tok)) || _mytoml_is_digit(_mytoml_tokenizer_get_token(tok))) {
@@ -2002,13 +3273,13 @@ int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len) {
             continue;
         } else {
             if (digits != 4 && digits != 8) {
-                LOG_ERR("Invalid unicode escape code\n");
+                PARSE_ERR(tok, TOML_DECODE, "invalid unicode escape code");
                 break;
             }
             char *end;
             unsigned long num = strtoul(code, &end, 16);
             if (end != code + digits) {
-                LOG_ERR("Invalid unicode escape code\n");
+                PARSE_ERR(tok, TOML_DECODE, "invalid unicode escape code");
                 break;
             }
             // Unicode Scalar Values: %x80-D7FF / %xE000-10FFFF
@@ -2016,14 +3287,14 @@ int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len) {
                 // UTF-8 encoding
                 if (num <= 0x0 && num <= 0x7F) {
                     if (len < 1) {
-                        LOG_ERR("escaped array is not long enough\n");
+                        PARSE_ERR(tok, TOML_DECODE, "escaped array is not long enough");
                         break;
                     }
                     escaped[0] = (num) & 0b01111111;
                     return 1;
                 } else if (num >= 0x80 && num <= 0x7FF) {
                     if (len < 2) {
-                        LOG_ERR("escaped array is not long enough\n");
+                        PARSE_ERR(tok, TOML_DECODE, "escaped array is not long enough");
                         break;
                     }
                     escaped[0] = (0b11000000 | (num >> 6)) & 0b11011111;
@@ -2031,7 +3302,7 @@ int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len) {
                     return 2;
                 } else if ((num >= 0x800 && num <= 0xFFFF)) {
                     if (len < 3) {
-                        LOG_ERR("escaped array is not long enough\n");
+                        PARSE_ERR(tok, TOML_DECODE, "escaped array is not long enough");
                         break;
                     }
                     escaped[0] = (0b11100000 | (num >> 12)) & 0b11101111;
@@ -2040,7 +3311,7 @@ int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len) {
                     return 3;
                 } else {
                     if (len < 4) {
-                        LOG_ERR("escaped array is not long enough\n");
+                        PARSE_ERR(tok, TOML_DECODE, "escaped array is not long enough");
                         break;
                     }
                     escaped[0] = (0b11110000 | (num >> 18)) & 0b11110111;
@@ -2051,7 +3322,7 @@ int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len) {
                 }
                 return 0;
             } else {
-                LOG_ERR("Invalid unicode escape code\n");
+                PARSE_ERR(tok, TOML_DECODE, "invalid unicode escape code");
                 break;
             }
         }
@@ -2061,7 +3332,7 @@ int _mytoml_parser_parse_unicode(Tokenizer *tok, char *escaped, int len) {
 
 int _mytoml_parser_parse_escape(Tokenizer *tok, char *escaped, int len) {
     if (len < 1) {
-        LOG_ERR("escaped array is not long enough\n");
+        PARSE_ERR(tok, TOML_DECODE, "escaped array is not long enough");
         return 0;
     }
     switch (_mytoml_tokenizer_get_token(tok)) {
@@ -2116,263 +3387,396 @@ int _mytoml_parser_parse_escape(Tokenizer *tok, char *escaped, int len) {
     return 0;
 }
 
-double _mytoml_parser_parse_base_unit(Tokenizer *tok, int base, char *value, const char *num_end) {
-    int idx = 0;
-    double d = -1;
-    while (_mytoml_tokenizer_has_token(tok)) {
-        if (idx >= MYTOML_MAX_STRING_LENGTH) {
-            LOG_ERR("buffer overflow\n");
+char *_mytoml_parser_parse_string(Tokenizer *tok, char *value, int size, int *len) {
+    Token t = tok->current;
+    char *s = NULL;
+    if (t.type == T_BASIC_STRING || t.type == T_LITERAL_STRING) {
+        const char *body = tok->input.stream + t.offset + 1;
+        size_t n = (size_t)t.length - 2;
+        char q = body[-1];
+        // nothing to decode, copy the body as is
+        if (_mytoml_scan_special(body, 0, n, q, (t.type == T_BASIC_STRING) ? '\\' : q) == n) {
+            PARSE_IF_FAILED(tok, n < (size_t)size, TOML_DECODE, "buffer overflow");
+            memcpy(value, body, n);
+            *len = (int)n;
+            return value;
+        }
+    }
+    switch (t.type) {
+        case T_BASIC_STRING:
+            _mytoml_tokenizer_seek(tok, t.offset + 1);
+            s = _mytoml_parser_parse_basic_string(tok, value, size, len, false);
+            break;
+        case T_ML_BASIC_STRING:
+            _mytoml_tokenizer_seek(tok, t.offset + 3);
+            s = _mytoml_parser_parse_basic_string(tok, value, size, len, true);
+            break;
+        case T_LITERAL_STRING:
+            _mytoml_tokenizer_seek(tok, t.offset + 1);
+            s = _mytoml_parser_parse_literal_string(tok, value, size, len, false);
+            break;
+        case T_ML_LITERAL_STRING:
+            _mytoml_tokenizer_seek(tok, t.offset + 3);
+            s = _mytoml_parser_parse_literal_string(tok, value, size, len, true);
+            break;
+        default:
+            PARSE_ERR(tok, TOML_DECODE, "expected a string");
+            break;
+    }
+    // the lexer already found the end of the string
+    tok->cursor = t.offset + t.length;
+    return s;
+}
+
+int _mytoml_parser_parse_digits(const char *s, int len, int *i, int base, char *value, int *idx) {
+    int count = 0;
+    while (*i < len) {
+        if (_mytoml_is_base_digit(s[*i], base)) {
+            value[(*idx)++] = s[*i];
+            count++;
+        } else if (!_mytoml_is_underscore(s[*i]) || count == 0 || *i + 1 >= len || !_mytoml_is_base_digit(s[*i + 1], base)) {
+            // underscores must be surrounded by digits
             break;
         }
-        if (_mytoml_is_number_end(_mytoml_tokenizer_get_token(tok), num_end)) {
-            if (idx == 0) {
-                LOG_ERR("incomplete non-decimal number\n");
-                break;
-            }
-            char *end;
-            unsigned long num = strtoul(value, &end, base);
-            if (end == value + idx) {
-                d = (double)num;
-            } else {
-                LOG_ERR("could not convert %s to base %d\n", value, base);
-            }
+        (*i)++;
+    }
+    return count;
+}
+
+bool _mytoml_parser_parse_integer(const char *s, int len, int base, int64_t *value) {
+    int i = 0;
+    bool negative = false;
+    if (base == 10 && i < len && (s[i] == '+' || s[i] == '-')) {
+        negative = (s[i++] == '-');
+    }
+    int start = i;
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    uint64_t n = 0;
+    int count = 0;
+    for (; i < len; i++) {
+        char c = s[i];
+        if (!_mytoml_is_base_digit(c, base)) {
+            // underscores must be surrounded by digits
+            if (_mytoml_is_underscore(c) && count > 0 && i + 1 < len && _mytoml_is_base_digit(s[i + 1], base)) continue;
             break;
-        } else if (_mytoml_is_underscore(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            if ((_mytoml_is_digit(_mytoml_tokenizer_get_token(tok)) || (base == 16 && _mytoml_is_hex_digit(_mytoml_tokenizer_get_token(tok)))) &&
-                (_mytoml_is_digit(_mytoml_tokenizer_get_prev_prev_token(tok)) ||
-                 (base == 16 && _mytoml_is_hex_digit(_mytoml_tokenizer_get_prev_prev_token(tok))))) {
-                value[idx++] = _mytoml_tokenizer_get_token(tok);
+        }
+        unsigned int d = (c <= '9') ? c - '0' : (c | 0x20) - 'a' + 10;
+        // does not fit in 64 bits
+        if (n > (limit - d) / base) return false;
+        n = n * base + d;
+        count++;
+    }
+    if (count == 0 || i != len) return false;
+    // no leading zeros for decimal integers
+    if (base == 10 && s[start] == '0' && count > 1) return false;
+    *value = negative ? -(int64_t)(n - 1) - 1 : (int64_t)n;
+    return true;
+}
+
+int _mytoml_parser_parse_significand(const char *s, int len, int *i, Decimal *d, bool fraction) {
+    int count = 0;
+    while (*i < len) {
+        char c = s[*i];
+        if (_mytoml_is_digit(c)) {
+            if (d->digits < 19) {
+                d->mantissa = d->mantissa * 10 + (c - '0');
+                // leading zeros are not significant
+                if (d->mantissa != 0) d->digits++;
+                if (fraction) d->exponent--;
             } else {
-                LOG_ERR("stray %c character\n", _mytoml_tokenizer_get_previous_token(tok));
-                break;
+                if (c != '0') d->truncated = true;
+                if (!fraction) d->exponent++;
             }
-        } else {
-            value[idx++] = _mytoml_tokenizer_get_token(tok);
+            count++;
+        } else if (!_mytoml_is_underscore(c) || count == 0 || *i + 1 >= len || !_mytoml_is_digit(s[*i + 1])) {
+            // underscores must be surrounded by digits
+            break;
         }
-        _mytoml_tokenizer_next_token(tok);
+        (*i)++;
     }
-    return d;
+    return count;
 }
 
-Number *_mytoml_parser_parse_number(Tokenizer *tok, char *value, double *d, const char *num_end, Number *n) {
+bool _mytoml_parser_parse_float(const char *s, int len, Decimal *d, double *number) {
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    bool negative = (s[0] == '-');
+    if (d->mantissa == 0) {
+        *number = negative ? -0.0 : 0.0;
+        return true;
+    }
+#if FLT_EVAL_METHOD == 0
+    // both the mantissa and the power of ten are exact doubles,
+    // so the result is correctly rounded
+    if (!d->truncated && d->mantissa <= (1ULL << 53) && d->exponent >= -22 && d->exponent <= 22) {
+        double m = (double)d->mantissa;
+        m = (d->exponent < 0) ? m / powers[-d->exponent] : m * powers[d->exponent];
+        *number = negative ? -m : m;
+        return true;
+    }
+#else
+    (void)powers;
+#endif  // FLT_EVAL_METHOD
+    char value[MYTOML_MAX_NUMBER_LENGTH];
+    int i = 0;
     int idx = 0;
+    int fraction = 0;
+    int exponent = 0;
+    bool decimal = false;
+    if (negative) value[idx++] = '-';
+    for (; i < len && s[i] != 'e' && s[i] != 'E'; i++) {
+        if (_mytoml_is_digit(s[i])) {
+            if (idx >= MYTOML_MAX_NUMBER_LENGTH - 16) return false;
+            value[idx++] = s[i];
+            if (decimal) fraction++;
+        } else if (_mytoml_is_decimal_point(s[i])) {
+            decimal = true;
+        }
+    }
+    if (i < len) {
+        bool minus = (s[++i] == '-');
+        for (; i < len; i++) {
+            if (_mytoml_is_digit(s[i]) && exponent < 100000) exponent = exponent * 10 + (s[i] - '0');
+        }
+        if (minus) exponent = -exponent;
+    }
+    idx += snprintf(value + idx, 16, "e%d", exponent - fraction);
+    char *end;
+    *number = strtod(value, &end);
+    return end == value + idx;
+}
+
+Number *_mytoml_parser_parse_number(const char *s, int len, Number *n) {
+    int i = 0;
     n->type = TOML_INT;
     n->scientific = false;
     n->precision = 0;
-    while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
-        if (_mytoml_is_number_end(_mytoml_tokenizer_get_token(tok), num_end)) {
-            char *end;
-            double num = strtod(value, &end);
-            RETURN_IF_FAILED(end == value + idx, "could not convert %s to double\n", value);
-            *d = num;
-            if (n->precision > 0) n->precision--;
-            if (n->type == TOML_INT && num != 0) {
-                RETURN_IF_FAILED(value[0] != '0', "cannot have leading zero for integers");
-                if (value[0] == '+' || value[0] == '-') {
-                    RETURN_IF_FAILED(value[1] != '0', "cannot have leading zero for signed integers");
-                }
-            }
-            return n;
-        } else if (idx == 0 && _mytoml_tokenizer_get_token(tok) == '0') {
-            double b;
-            _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_tokenizer_get_token(tok) == 'x') {
-                // hexadecimal
-                _mytoml_tokenizer_next_token(tok);
-                b = _mytoml_parser_parse_base_unit(tok, 16, value, num_end);
-            } else if (_mytoml_tokenizer_get_token(tok) == 'o') {
-                // octal
-                _mytoml_tokenizer_next_token(tok);
-                b = _mytoml_parser_parse_base_unit(tok, 8, value, num_end);
-            } else if (_mytoml_tokenizer_get_token(tok) == 'b') {
-                // binary
-                _mytoml_tokenizer_next_token(tok);
-                b = _mytoml_parser_parse_base_unit(tok, 2, value, num_end);
-            } else {
-                value[idx++] = '0';
-                continue;
-            }
-            RETURN_IF_FAILED(b != -1, "invalid non-decimal number\n");
-            *d = b;
-            return n;
-        } else if (_mytoml_is_decimal_point(_mytoml_tokenizer_get_token(tok)) || _mytoml_is_underscore(_mytoml_tokenizer_get_token(tok))) {
-            if (_mytoml_is_decimal_point(_mytoml_tokenizer_get_token(tok))) {
-                value[idx++] = _mytoml_tokenizer_get_token(tok);
-                n->type = TOML_FLOAT;
-                n->precision = 1;
-            }
-            RETURN_IF_FAILED(idx < MYTOML_MAX_STRING_LENGTH, "buffer overflow\n");
-            _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_is_digit(_mytoml_tokenizer_get_token(tok)) && _mytoml_is_digit(_mytoml_tokenizer_get_prev_prev_token(tok))) {
-                if (n->precision > 0) n->precision++;
-                value[idx++] = _mytoml_tokenizer_get_token(tok);
-            } else {
-                LOG_ERR("stray %c character\n", _mytoml_tokenizer_get_previous_token(tok));
-                return NULL;
+    if (len >= MYTOML_MAX_NUMBER_LENGTH) return NULL;
+    if (len > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'o' || s[1] == 'b')) {
+        int base = (s[1] == 'x') ? 16 : (s[1] == 'o') ? 8 : 2;
+        if (!_mytoml_parser_parse_integer(s + 2, len - 2, base, &n->integer)) return NULL;
+        return n;
+    }
+    if (!memchr(s, '.', len) && !memchr(s, 'e', len) && !memchr(s, 'E', len)) {
+        if (!_mytoml_parser_parse_integer(s, len, 10, &n->integer)) return NULL;
+        return n;
+    }
+    n->type = TOML_FLOAT;
+    Decimal d = {0};
+    if (s[i] == '+' || s[i] == '-') i++;
+    int start = i;
+    int digits = _mytoml_parser_parse_significand(s, len, &i, &d, false);
+    if (digits == 0) return NULL;
+    // no leading zeros in the integer part
+    if (s[start] == '0' && digits > 1) return NULL;
+    if (i < len && _mytoml_is_decimal_point(s[i])) {
+        i++;
+        n->precision = _mytoml_parser_parse_significand(s, len, &i, &d, true);
+        // a . must be followed by digits
+        if (n->precision == 0) return NULL;
+    }
+    if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        n->scientific = true;
+        bool negative = false;
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            negative = (s[i++] == '-');
+        }
+        int exponent = 0;
+        int count = 0;
+        for (; i < len; i++) {
+            if (_mytoml_is_digit(s[i])) {
+                // anything this large is already zero or infinity
+                if (exponent < 100000) exponent = exponent * 10 + (s[i] - '0');
+                count++;
+            } else if (!_mytoml_is_underscore(s[i]) || count == 0 || i + 1 >= len || !_mytoml_is_digit(s[i + 1])) {
+                break;
             }
-        } else if (_mytoml_tokenizer_get_token(tok) == 'i' || _mytoml_tokenizer_get_token(tok) == 'n') {
-            if (idx == 1 && (_mytoml_tokenizer_get_previous_token(tok) == '+' || _mytoml_tokenizer_get_previous_token(tok) == '-')) {
-                double f = _mytoml_parser_parse_lnf_nan(tok, (_mytoml_tokenizer_get_previous_token(tok) == '-'));
-                if (f == 0) break;
-                *d = f;
-                n->type = TOML_FLOAT;
-                n->precision = 0;
-                return n;
+        }
+        if (count == 0) return NULL;
+        d.exponent += negative ? -exponent : exponent;
+    }
+    if (i != len || !_mytoml_parser_parse_float(s, len, &d, &n->number)) return NULL;
+    return n;
+}
+
+TomlValue *_mytoml_parser_parse_value(Tokenizer *tok) {
+    if (tok->current.type == T_WHITESPACE) {
+        _mytoml_lexer_next(tok, true);
+    }
+    const char *s = tok->input.stream + tok->current.offset;
+    int len = tok->current.length;
+    TomlValue *v = NULL;
+    switch (tok->current.type) {
+        case T_EOF:
+        case T_NEWLINE:
+        case T_COMMENT: {
+            PARSE_ERR(tok, MISSING_VALUE, "got a newline before any value");
+            return NULL;
+        }
+        case T_BASIC_STRING:
+        case T_ML_BASIC_STRING:
+        case T_LITERAL_STRING:
+        case T_ML_LITERAL_STRING: {
+            bool ml = (tok->current.type == T_ML_BASIC_STRING || tok->current.type == T_ML_LITERAL_STRING);
+            int size = len - (ml ? 6 : 2) + 1;
+            int n = 0;
+            char *value = (char *)_mytoml_alloc(tok->arena, size);
+            PARSE_IF_FAILED(tok, value, TOML_MEMORY, "could not allocate string");
+            char *str = _mytoml_parser_parse_string(tok, value, size, &n);
+            FUNC_IF_FAILED(str, _mytoml_free, tok->arena, value);
+            PARSE_IF_FAILED(tok, str, TOML_DECODE, "could not parse string");
+            value[n] = '\0';
+            v = _mytoml_value_new_string(tok->arena, value, n);
+            FUNC_IF_FAILED(v, _mytoml_free, tok->arena, value);
+            break;
+        }
+        case T_LBRACKET: {
+            TomlValue *arr = _mytoml_value_new_array(tok->arena);
+            PARSE_IF_FAILED(tok, arr, TOML_MEMORY, "could not allocate array");
+            _mytoml_lexer_next(tok, true);
+            v = _mytoml_parser_parse_array(tok, arr);
+            FUNC_IF_FAILED(v, _mytoml_value_delete, tok->arena, arr);
+            PARSE_IF_FAILED(tok, v, TOML_DECODE, "could not parse array");
+            break;
+        }
+        case T_LBRACE: {
+            // only array elements get here, pairs are parsed
+            // straight into their key by `_mytoml_parser_parse_leaf_value`
+            _mytoml_lexer_next(tok, false);
+            TomlKey *keys = _mytoml_value_new_key(tok->arena, TOML_KEY);
+            PARSE_IF_FAILED(tok, keys, TOML_MEMORY, "could not allocate inline table");
+            v = _mytoml_value_new_table(tok->arena, keys);
+            FUNC_IF_FAILED(v, _mytoml_value_delete_key, tok->arena, keys);
+            PARSE_IF_FAILED(tok, v, TOML_MEMORY, "could not allocate inline table");
+            TomlKey *k = _mytoml_parser_parse_inline_tabel(tok, keys);
+            FUNC_IF_FAILED(k, _mytoml_value_delete, tok->arena, v);
+            PARSE_IF_FAILED(tok, k, TOML_DECODE, "could not parse inline table");
+            break;
+        }
+        case T_BARE: {
+            int sign = (s[0] == '+' || s[0] == '-') ? 1 : 0;
+            if ((len == 4 && memcmp(s, "true", 4) == 0) || (len == 5 && memcmp(s, "false", 5) == 0)) {
+                double b = (s[0] == 't') ? 1.0 : 0.0;
+                v = _mytoml_value_new_number(tok->arena, &b, TOML_BOOL, 0, false);
+            } else if (len == 3 + sign && (memcmp(s + sign, "inf", 3) == 0 || memcmp(s + sign, "nan", 3) == 0)) {
+                double f = (s[sign] == 'i') ? (double)INFINITY : (double)NAN;
+                if (s[0] == '-') f = -f;
+                v = _mytoml_value_new_number(tok->arena, &f, TOML_FLOAT, 0, false);
+            } else if (len > 2 && _mytoml_is_digit(s[0]) &&
+                       (s[2] == ':' || (len > 4 && _mytoml_is_digit(s[1]) && _mytoml_is_digit(s[2]) && _mytoml_is_digit(s[3]) && s[4] == '-'))) {
+                Datetime dt;
+                PARSE_IF_FAILED(tok, _mytoml_parser_parse_datetime(s, len, &dt), TOML_DECODE, "could not parse datetime");
+                v = _mytoml_value_new_datetime(tok->arena, &dt.value, dt.type, dt.precision);
+            } else if (_mytoml_is_number_start(s[0])) {
+                Number n;
+                Number *num = _mytoml_parser_parse_number(s, len, &n);
+                PARSE_IF_FAILED(tok, num, TOML_DECODE, "could not parse number");
+                if (n.type == TOML_INT) {
+                    v = _mytoml_value_new_integer(tok->arena, n.integer);
+                } else {
+                    v = _mytoml_value_new_number(tok->arena, &n.number, n.type, n.precision, n.scientific);
+                }
             } else {
-                LOG_ERR("unknown or invalid number\n");
+                PARSE_ERR(tok, TOML_DECODE, "unknown value type");
                 return NULL;
             }
-        } else if (_mytoml_tokenizer_get_token(tok) == 'x' || _mytoml_tokenizer_get_token(tok) == 'X' || _mytoml_tokenizer_get_token(tok) == 'b' ||
-                   _mytoml_tokenizer_get_token(tok) == 'B' || _mytoml_tokenizer_get_token(tok) == 'o' || _mytoml_tokenizer_get_token(tok) == 'O') {
-            LOG_ERR("invalid decimal number, found stray character %c\n", _mytoml_tokenizer_get_token(tok));
             break;
-        } else {
-            value[idx++] = _mytoml_tokenizer_get_token(tok);
-            if (n->precision > 0) n->precision++;
-            if (_mytoml_tokenizer_get_token(tok) == 'e' || _mytoml_tokenizer_get_token(tok) == 'E') {
-                n->type = TOML_FLOAT;
-                n->scientific = true;
-            }
         }
-        _mytoml_tokenizer_next_token(tok);
+        default: {
+            PARSE_ERR(tok, TOML_DECODE, "unknown value type");
+            return NULL;
+        }
     }
-    char *end;
-    double num = strtod(value, &end);
-    RETURN_IF_FAILED(end == value + idx, "could not convert %s to double\n", value);
-    *d = num;
-    if (n->precision > 0) n->precision--;
-    if (n->type == TOML_INT && num != 0) {
-        RETURN_IF_FAILED(value[0] != '0', "cannot have leading zero for integers");
-        if (value[0] == '+' || value[0] == '-') {
-            RETURN_IF_FAILED(value[1] != '0', "cannot have leading zero for signed integers");
+    PARSE_IF_FAILED(tok, v, TOML_MEMORY, "could not allocate value");
+    _mytoml_lexer_next(tok, true);
+    return v;
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Myjson Parallel
+//-----------------------------------------------------------------------------
+
+int _mytoml_parallel_split(const char *s, size_t size, size_t *split, int n) {
+    int count = 0;
+    int depth = 0;
+    char quote = 0;
+    size_t pos = 0;
+    while (pos < size && count < n - 1) {
+        // `pos` is at the start of a line
+        size_t first = _mytoml_scan_whitespace(s, pos, size);
+        if (first < size && s[first] == '[' && depth == 0 && quote == 0 && pos >= size / n * (count + 1)) {
+            split[count++] = pos;
         }
+        pos = _mytoml_scan_line(s, pos, size, &depth, &quote);
+        if (pos == 0) break;
     }
-    return n;
+    return count;
 }
 
-TomlValue *_mytoml_parser_parse_value(Tokenizer *tok, const char *num_end) {
-    while (_mytoml_tokenizer_has_token(tok)) {
-        RETURN_IF_FAILED(!_mytoml_parser_parse_newline(tok), "got a newline before any value\n");
-        if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_parser_parse_whitespace(tok);
+bool _mytoml_parallel_merge(TomlArena *arena, TomlKey *into, TomlKey *from, int *continued) {
+    // keys added to an ARRAYTABLE go to its last element
+    TomlKey *owner = (into->type == TOML_ARRAYTABLE) ? into->value->arr[into->idx]->table : into;
+    for (int i = 0; i < from->subkeys.len; i++) {
+        TomlEntry *entry = &from->subkeys.entry[i];
+        TomlKey *subkey = entry->key;
+        TomlKey *k = _mytoml_value_find_sub_key(owner, subkey->id, ID_LENGTH(subkey->id), entry->hash);
+        if (k == NULL) {
+            if (owner->subkeys.len >= MYTOML_MAX_SUBKEYS) return false;
+            if (!_mytoml_value_put_sub_key(arena, owner, subkey, entry->hash)) return false;
+            entry->key = NULL;
             continue;
-        } else if (_mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-            char value[MYTOML_MAX_STRING_LENGTH] = {0};
-            char *s;
-            _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_tokenizer_has_token(tok) && _mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-                _mytoml_tokenizer_next_token(tok);
-                if (_mytoml_tokenizer_has_token(tok) && _mytoml_is_basic_string_start(_mytoml_tokenizer_get_token(tok))) {
-                    _mytoml_tokenizer_next_token(tok);
-                    s = _mytoml_parser_parse_basic_string(tok, value, true);
-                } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok)) || _mytoml_parser_parse_newline(tok)) {
-                    s = value;
-                } else {
-                    LOG_ERR("cannot start string with 2 double-quotes\n");
-                    break;
-                }
-            } else {
-                s = _mytoml_parser_parse_basic_string(tok, value, false);
+        }
+        if (!_mytoml_value_keys_compatible(k->type, subkey->type)) return false;
+        if (subkey->type == TOML_ARRAYTABLE) {
+            int first = 0;
+            TomlKey *rest = subkey->value->arr[0]->table;
+            if (rest->type == TOML_TABLE) {
+                // the rest of the last element, see `_mytoml_parallel_continue`
+                if (!_mytoml_parallel_merge(arena, k, rest, continued)) return false;
+                (*continued)--;
+                first = 1;
             }
-            RETURN_IF_FAILED(s, "could not parse basic string\n");
-            TomlValue *v = _mytoml_value_new_string(value);
-            return v;
-        } else if (_mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-            char value[MYTOML_MAX_STRING_LENGTH] = {0};
-            char *s;
-            _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_tokenizer_has_token(tok) && _mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-                _mytoml_tokenizer_next_token(tok);
-                if (_mytoml_tokenizer_has_token(tok) && _mytoml_is_literal_string_start(_mytoml_tokenizer_get_token(tok))) {
-                    _mytoml_tokenizer_next_token(tok);
-                    s = _mytoml_parser_parse_literal_string(tok, value, true);
-                } else if (_mytoml_is_whitesapce(_mytoml_tokenizer_get_token(tok)) || _mytoml_parser_parse_newline(tok)) {
-                    s = value;
-                } else {
-                    LOG_ERR("cannot start string with 2 single-quotes\n");
-                    break;
-                }
-            } else {
-                s = _mytoml_parser_parse_literal_string(tok, value, false);
+            // both chunks added elements, which continue the array
+            for (int j = first; j < subkey->value->len; j++) {
+                if (!_mytoml_value_array_push(arena, k->value, subkey->value->arr[j])) return false;
+                subkey->value->arr[j] = NULL;
             }
-            RETURN_IF_FAILED(s, "could not parse literal string\n");
-            TomlValue *v = _mytoml_value_new_string(value);
-            return v;
-        } else if (_mytoml_is_number_start(_mytoml_tokenizer_get_token(tok))) {
-            char value[MYTOML_MAX_STRING_LENGTH] = {0};
-            // try parsing date time
-            bool a = _mytoml_tokenizer_next_token(tok);
-            bool b = _mytoml_tokenizer_next_token(tok);
-            if (_mytoml_tokenizer_has_token(tok) && _mytoml_tokenizer_get_token(tok) == ':') {
-                _mytoml_tokenizer_backtrace(tok, a + b);
-                struct tm *time = (struct tm *)calloc(1, sizeof(struct tm));
-                Datetime *dt = _mytoml_parser_parse_datetime(tok, value, num_end, time);
-                FUNC_IF_FAILED(dt, free, time);
-                RETURN_IF_FAILED(dt, "could not parse time\n");
-                TomlValue *v = _mytoml_value_new_datetime(dt->dt, dt->type, dt->format, dt->millis);
-                free(dt);
-                free(time);
-                return v;
-            } else if (!_mytoml_is_digit(_mytoml_tokenizer_get_previous_token(tok)) || !_mytoml_is_digit(_mytoml_tokenizer_get_token(tok))) {
-                _mytoml_tokenizer_backtrace(tok, a + b);
-            } else {
-                bool c = _mytoml_tokenizer_next_token(tok);
-                bool d = _mytoml_tokenizer_next_token(tok);
-                if (_mytoml_tokenizer_has_token(tok) && _mytoml_tokenizer_get_token(tok) == '-') {
-                    _mytoml_tokenizer_backtrace(tok, a + b + c + d);
-                    struct tm *time = (struct tm *)calloc(1, sizeof(struct tm));
-                    Datetime *dt = _mytoml_parser_parse_datetime(tok, value, num_end, time);
-                    FUNC_IF_FAILED(dt, free, time);
-                    RETURN_IF_FAILED(dt, "could not parse datetime\n");
-                    TomlValue *v = _mytoml_value_new_datetime(dt->dt, dt->type, dt->format, dt->millis);
-                    free(dt);
-                    free(time);
-                    return v;
-                } else {
-                    _mytoml_tokenizer_backtrace(tok, a + b + c + d);
-                }
-            }
-            double *d = (double *)calloc(1, sizeof(double));
-            Number *num = (Number *)calloc(1, sizeof(Number));
-            Number *n = _mytoml_parser_parse_number(tok, value, d, num_end, num);
-            FUNC_IF_FAILED(n, free, d);
-            FUNC_IF_FAILED(n, free, n);
-            RETURN_IF_FAILED(n, "could not parse number\n");
-            TomlValue *v = _mytoml_value_new_number(d, n->type, n->precision, n->scientific);
-            free(d);
-            free(n);
-            return v;
-        } else if (_mytoml_is_array_start(_mytoml_tokenizer_get_token(tok))) {
-            TomlValue *v = _mytoml_value_new_array();
-            _mytoml_tokenizer_next_token(tok);
-            TomlValue *val = _mytoml_parser_parse_array(tok, v);
-            FUNC_IF_FAILED(val, _mytoml_value_delete, v);
-            RETURN_IF_FAILED(val, "could not parse array\n");
-            return val;
-        } else if (_mytoml_is_inline_table_start(_mytoml_tokenizer_get_token(tok))) {
-            _mytoml_tokenizer_next_token(tok);
-            TomlKey *keys = _mytoml_parser_parse_inline_tabel(tok);
-            RETURN_IF_FAILED(keys, "could not parse inline table\n");
-            TomlValue *v = _mytoml_value_new_table(keys);
-            return v;
-        } else if (_mytoml_tokenizer_get_token(tok) == 't' || _mytoml_tokenizer_get_token(tok) == 'f') {
-            double b = _mytoml_parser_parse_boolean(tok);
-            RETURN_IF_FAILED((b == 1 || b == 0), "expecting true or false but could not parse\n");
-            TomlValue *v = _mytoml_value_new_number(&b, TOML_BOOL, 0, false);
-            return v;
-        } else if (_mytoml_tokenizer_get_token(tok) == 'i' || _mytoml_tokenizer_get_token(tok) == 'n') {
-            double f = _mytoml_parser_parse_lnf_nan(tok, false);
-            RETURN_IF_FAILED(f, "expecting inf or nan but could not parse\n");
-            TomlValue *v = _mytoml_value_new_number(&f, TOML_FLOAT, 0, false);
-            return v;
-        } else {
-            LOG_ERR("unknown value type\n");
-            break;
+            k->idx = k->value->len - 1;
+            continue;
+        }
+        if (subkey->type == TOML_TABLELEAF) {
+            k->type = TOML_TABLELEAF;
         }
+        if (!_mytoml_parallel_merge(arena, k, subkey, continued)) return false;
     }
-    return NULL;
+    return true;
+}
+
+bool _mytoml_parallel_continue(Tokenizer *tok, TomlKey *key, const char *id) {
+    TomlKey *owner = (key->type == TOML_ARRAYTABLE) ? key->value->arr[key->idx]->table : key;
+    TomlKey *k = _mytoml_value_find_sub_key(owner, id, ID_LENGTH(id), ID_HASH(id));
+    // only a table never defined in this chunk can be an element
+    if (k == NULL || k->type != TOML_TABLE) return true;
+    TomlKey *rest = _mytoml_value_new_key(tok->arena, TOML_KEY);
+    if (rest == NULL) return false;
+    TomlValue *element = _mytoml_value_new_table(tok->arena, rest);
+    FUNC_IF_FAILED(element, _mytoml_value_delete_key, tok->arena, rest);
+    if (element == NULL) return false;
+    TomlValue *array = _mytoml_value_new_array(tok->arena);
+    if (array == NULL || !_mytoml_value_array_push(tok->arena, array, element)) {
+        _mytoml_value_delete(tok->arena, element);
+        _mytoml_value_delete(tok->arena, array);
+        return false;
+    }
+    rest->type = TOML_TABLE;
+    rest->subkeys = k->subkeys;
+    k->subkeys = (TomlTable){0};
+    k->type = TOML_ARRAYTABLE;
+    k->value = array;
+    k->idx = 0;
+    (*tok->continued)++;
+    return true;
 }
 
 #ifdef __cplusplus
@@ -2407,248 +3811,531 @@ TomlValue *_mytoml_parser_parse_value(Tokenizer *tok, const char *num_end) {
 extern "C" {
 #endif  // __cplusplus
 
-MYTOML_API TomlKey *toml_load_file_name(char *file) {
-    TomlKey *root = _mytoml_value_new_key(TOML_TABLE);
-    memcpy(root->id, "root", strlen("root"));
+/*
+    Function `_mytoml_new_root` allocates the `root` key of the
+    document parsed by `tok`, along with its arena and the pool
+    its identifiers are interned in. Returns NULL with the
+    error recorded in `tok` on failure.
+*/
+static TomlKey *_mytoml_new_root(Tokenizer *tok) {
+#if MYTOML_USE_ARENA
+    tok->arena = _mytoml_arena_new();
+    PARSE_IF_FAILED(tok, tok->arena, TOML_MEMORY, "could not allocate arena");
+#endif  // MYTOML_USE_ARENA
+    TomlDocument *doc = (TomlDocument *)_mytoml_alloc(tok->arena, sizeof(TomlDocument));
+    if (!doc) _mytoml_arena_delete(tok->arena);
+    PARSE_IF_FAILED(tok, doc, TOML_MEMORY, "could not allocate root key");
+    doc->root = (TomlKey){.type = TOML_TABLE, .id = _mytoml_empty_id.bytes, .idx = TOML_KEY_NO_INDEX};
+    doc->arena = tok->arena;
+    // identifiers live in the document arena, or in an arena of their own
+    doc->ids = tok->arena ? NULL : _mytoml_arena_new();
+    tok->pool.arena = tok->arena ? tok->arena : doc->ids;
+    TomlKey *root = &doc->root;
+    tok->pool.ids = kh_init(id);
+    root->id = (tok->pool.arena && tok->pool.ids) ? _mytoml_intern(&tok->pool, "root", strlen("root")) : NULL;
+    FUNC_IF_FAILED(root->id, toml_free, root);
+    PARSE_IF_FAILED(tok, root->id, TOML_MEMORY, "could not allocate identifiers");
+    return root;
+}
 
-    Input input = {.type = I_File, .file.name = file};
-    Tokenizer *tok = _mytoml_new_tokenizer(input);
-    bool ok = _mytoml_tokenizer_load_input(tok);
-    RETURN_IF_FAILED(ok, "Failed to load input from %s\n", input.file.name);
-    _mytoml_tokenizer_next_token(tok);
+/*
+    Function `_mytoml_parse_root` runs the parser over a
+    tokenizer whose input is already loaded and returns the
+    `root` key, or NULL with the error recorded in `tok`.
+*/
+static TomlKey *_mytoml_parse_root(Tokenizer *tok) {
+    TomlKey *root = _mytoml_new_root(tok);
+    if (!root) return NULL;
+
+    _mytoml_lexer_next(tok, false);
 
-    int line, col;
     TomlKey *key = root;
-    while (_mytoml_tokenizer_has_token(tok) != 0) {
+    while (tok->current.type != T_EOF) {
         key = _mytoml_parser_parse_key_value(tok, key, root);
-        line = tok->line;
-        col = tok->col;
-        FUNC_IF_FAILED(key, _mytoml_tokenizer_delete, tok);
         FUNC_IF_FAILED(key, toml_free, root);
-        RETURN_IF_FAILED(key,
-                         "Encountered an error while parsing %s\n"
-                         "At line %d column %d\n",
-                         file, line + 1, col);
+        if (!key) return NULL;
     }
+    return root;
+}
 
+/*
+    Function `_mytoml_parse` loads the input of `tok` and parses
+    it. The first error met is stored in `err`, with its line
+    and column, or `TOML_OK` on success. Nothing is printed and
+    no state is shared, so documents can be parsed from many
+    threads at once. The tokenizer, NULL if it could not be
+    allocated, is deleted in all cases.
+*/
+static TomlKey *_mytoml_parse(Tokenizer *tok, TomlError_t *err) {
+    if (tok == NULL) {
+        *err = (TomlError_t){TOML_MEMORY, "could not allocate tokenizer", 0, 0};
+        return NULL;
+    }
+    TomlKey *root = NULL;
+    if (_mytoml_tokenizer_load_input(tok)) {
+        root = _mytoml_parse_root(tok);
+        if (root == NULL) {
+            int line, col;
+            _mytoml_tokenizer_location(tok, tok->error_offset, &line, &col);
+            tok->error.line = line + 1;
+            tok->error.column = col + 1;
+        }
+    }
+    if (root == NULL && tok->error.type == TOML_OK) {
+        tok->error = (TomlError_t){TOML_UNKNOWN, "unknown error", 0, 0};
+    }
+    *err = tok->error;
     _mytoml_tokenizer_delete(tok);
     return root;
-};
+}
 
-MYTOML_API TomlKey *toml_load_file(FILE *file) {
-    TomlKey *root = _mytoml_value_new_key(TOML_TABLE);
-    memcpy(root->id, "root", strlen("root"));
+/*
+    Function `_mytoml_load` parses `tok` for the loading
+    functions, which only return NULL on failure.
+*/
+static TomlKey *_mytoml_load(Tokenizer *tok) {
+    TomlError_t err;
+    return _mytoml_parse(tok, &err);
+}
 
-    Input input = {.type = I_File, .file.pointer = file};
+#if MYTOML_USE_THREADS
+
+/*
+    Function `_mytoml_parse_job` parses the chunk of `arg`, a
+    `ParseJob`, into its `root`. It is run on the threads
+    started by `_mytoml_parse_parallel`.
+*/
+static void *_mytoml_parse_job(void *arg) {
+    ParseJob *job = (ParseJob *)arg;
+    Input input = {.type = I_STREAM, .stream = job->stream, .size = job->size, .owned = false};
+    TomlError_t err;
     Tokenizer *tok = _mytoml_new_tokenizer(input);
-    bool ok = _mytoml_tokenizer_load_input(tok);
-    RETURN_IF_FAILED(ok, "Failed to load input from %s\n", "FILE");
-    _mytoml_tokenizer_next_token(tok);
+    // the first chunk starts the document, later ones may continue it
+    if (tok && !job->first) tok->continued = &job->continued;
+    job->root = _mytoml_parse(tok, &err);
+    return NULL;
+}
 
-    int line, col;
-    TomlKey *key = root;
-    while (_mytoml_tokenizer_has_token(tok) != 0) {
-        key = _mytoml_parser_parse_key_value(tok, key, root);
-        line = tok->line;
-        col = tok->col;
-        FUNC_IF_FAILED(key, _mytoml_tokenizer_delete, tok);
-        FUNC_IF_FAILED(key, toml_free, root);
-        RETURN_IF_FAILED(key,
-                         "Encountered an error while parsing %s\n"
-                         "At line %d column %d\n",
-                         "FILE", line + 1, col);
+/*
+    Function `_mytoml_parse_parallel` cuts `buf` into up to
+    `threads` chunks at table headers, parses them at the same
+    time and merges them, in document order, into the document
+    of the first chunk. Returns NULL if `buf` could not be cut
+    or if any chunk or merge failed. The caller then parses
+    `buf` sequentially, which also reports the error.
+*/
+static TomlKey *_mytoml_parse_parallel(const char *buf, size_t len, int threads) {
+    ParseJob *jobs = (ParseJob *)calloc(threads, sizeof(ParseJob));
+    size_t *split = (size_t *)malloc(sizeof(size_t) * threads);
+    int n = (jobs && split) ? _mytoml_parallel_split(buf, len, split, threads) + 1 : 0;
+    if (n < 2) {
+        free(jobs);
+        free(split);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        size_t start = (i > 0) ? split[i - 1] : 0;
+        size_t end = (i < n - 1) ? split[i] : len;
+        jobs[i].stream = buf + start;
+        jobs[i].size = end - start;
+        jobs[i].first = (i == 0);
+    }
+    // the calling thread parses the first chunk itself
+    for (int i = 1; i < n; i++) {
+        jobs[i].started = (pthread_create(&jobs[i].thread, NULL, _mytoml_parse_job, &jobs[i]) == 0);
+        if (!jobs[i].started) _mytoml_parse_job(&jobs[i]);
+    }
+    _mytoml_parse_job(&jobs[0]);
+    for (int i = 1; i < n; i++) {
+        if (jobs[i].started) pthread_join(jobs[i].thread, NULL);
     }
 
-    _mytoml_tokenizer_delete(tok);
+    TomlKey *root = jobs[0].root;
+    bool ok = (root != NULL);
+    for (int i = 1; i < n; i++) {
+        TomlKey *doc = jobs[i].root;
+        ok = ok && (doc != NULL);
+        if (!ok) {
+            toml_free(doc);
+        } else if (DOCUMENT_OF(root)->arena) {
+            // the nodes of `doc` are kept alive by its arena
+            _mytoml_arena_adopt(DOCUMENT_OF(root)->arena, DOCUMENT_OF(doc)->arena);
+            ok = _mytoml_parallel_merge(DOCUMENT_OF(root)->arena, root, doc, &jobs[i].continued);
+        } else {
+            // only the nodes left behind in `doc` are freed
+            _mytoml_arena_adopt(DOCUMENT_OF(root)->ids, DOCUMENT_OF(doc)->ids);
+            DOCUMENT_OF(doc)->ids = NULL;
+            ok = _mytoml_parallel_merge(NULL, root, doc, &jobs[i].continued);
+            toml_free(doc);
+        }
+        // a continued array moved over as a whole had nothing to continue
+        ok = ok && (jobs[i].continued == 0);
+    }
+    if (!ok) {
+        toml_free(root);
+        root = NULL;
+    }
+    free(jobs);
+    free(split);
     return root;
-};
+}
 
-MYTOML_API TomlKey *toml_loads(const char *toml) {
-    TomlKey *root = _mytoml_value_new_key(TOML_TABLE);
-    memcpy(root->id, "root", strlen("root"));
+#endif  // MYTOML_USE_THREADS
 
-    Input input = {.type = I_STREAM, .stream = strdup(toml)};
-    Tokenizer *tok = _mytoml_new_tokenizer(input);
-    _mytoml_tokenizer_next_token(tok);
+/*
+    Function `_mytoml_stream_fail` frees the document of
+    `stream` after an error, which is kept in its tokenizer.
+    Returns false so callers can return its result.
+*/
+static bool _mytoml_stream_fail(TomlStream *stream) {
+    toml_free(stream->root);
+    stream->root = NULL;
+    return false;
+}
 
-    int line, col;
-    TomlKey *key = root;
-    while (_mytoml_tokenizer_has_token(tok) != 0) {
-        key = _mytoml_parser_parse_key_value(tok, key, root);
-        line = tok->line;
-        col = tok->col;
-        FUNC_IF_FAILED(key, _mytoml_tokenizer_delete, tok);
-        FUNC_IF_FAILED(key, toml_free, root);
-        RETURN_IF_FAILED(key,
-                         "Encountered an error while parsing %s\n"
-                         "At line %d column %d\n",
-                         "FILE", line + 1, col);
+/*
+    Function `_mytoml_stream_parse` parses the `size` bytes at
+    `s`, whole statements spanning `lines` lines, into the
+    document of `stream`, carrying on in the table the last
+    batch ended in. The error location is counted from the
+    start of the document. Returns false on failure.
+*/
+static bool _mytoml_stream_parse(TomlStream *stream, const char *s, size_t size, int lines) {
+    Tokenizer *tok = stream->tok;
+    tok->input.stream = s;
+    tok->input.size = size;
+    tok->cursor = 0;
+    tok->token = '\0';
+    tok->is_null = true;
+    _mytoml_lexer_next(tok, false);
+    while (tok->current.type != T_EOF) {
+        stream->table = _mytoml_parser_parse_key_value(tok, stream->table, stream->root);
+        if (stream->table == NULL) {
+            int line, col;
+            _mytoml_tokenizer_location(tok, tok->error_offset, &line, &col);
+            tok->error.line = stream->line + line + 1;
+            tok->error.column = col + 1;
+            return _mytoml_stream_fail(stream);
+        }
     }
+    stream->line += lines;
+    return true;
+}
 
-    _mytoml_tokenizer_delete(tok);
+/*
+    Function `_mytoml_stream_carry` appends the `n` bytes at
+    `s` to the statement `stream` holds on to. Returns false
+    if it would grow past `MYTOML_MAX_STREAM_CARRY` or could
+    not be allocated.
+*/
+static bool _mytoml_stream_carry(TomlStream *stream, const char *s, size_t n) {
+    Tokenizer *tok = stream->tok;
+    if (n == 0) return true;
+    if (stream->len + n > MYTOML_MAX_STREAM_CARRY) {
+        tok->error = (TomlError_t){TOML_READ, "statement is too big", stream->line + 1, 1};
+        return _mytoml_stream_fail(stream);
+    }
+    if (stream->len + n > stream->cap) {
+        size_t cap = (stream->cap > 0) ? stream->cap : 4096;
+        while (cap < stream->len + n) cap *= 2;
+        char *carry = (char *)realloc(stream->carry, cap);
+        if (carry == NULL) {
+            tok->error = (TomlError_t){TOML_MEMORY, "could not allocate stream buffer", stream->line + 1, 1};
+            return _mytoml_stream_fail(stream);
+        }
+        stream->carry = carry;
+        stream->cap = cap;
+    }
+    memcpy(stream->carry + stream->len, s, n);
+    stream->len += n;
+    return true;
+}
+
+/*
+    Function `_mytoml_load_stream` reads `file`, which cannot
+    be seeked, into a `TomlStream` one piece at a time, so
+    pipes and `stdin` are parsed without knowing their size.
+*/
+static TomlKey *_mytoml_load_stream(FILE *file) {
+    char chunk[16384];
+    TomlStream *stream = toml_stream_new();
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        if (!toml_stream_feed(stream, chunk, n)) break;
+    }
+    TomlError_t err;
+    TomlKey *root = toml_stream_finish(stream, &err);
+    if (root && ferror(file)) {
+        toml_free(root);
+        root = NULL;
+    }
     return root;
+}
+
+MYTOML_API TomlKey *toml_load_file_name(char *file) {
+    Input input = {.type = I_File, .file.name = file};
+    return _mytoml_load(_mytoml_new_tokenizer(input));
+};
+
+MYTOML_API TomlKey *toml_load_file(FILE *file) {
+    // pipes and terminals cannot be sized up front
+    if (ftell(file) < 0) return _mytoml_load_stream(file);
+    Input input = {.type = I_FILE, .file.pointer = file};
+    return _mytoml_load(_mytoml_new_tokenizer(input));
 };
 
-MYTOML_API void toml_key_dump_file(TomlKey *object, FILE *file) { fprintf(file, "%s", toml_key_dumps(object)); };
+MYTOML_API TomlKey *toml_loads(const char *toml) { return toml_loads_n(toml, strlen(toml)); };
 
-MYTOML_API void toml_key_dump_file_name(TomlKey *object, const char *file) {
-    FILE *stream;
-    stream = fopen(file, "w");
-    const char *buffer = toml_key_dumps(object);
-    fwrite(buffer, strlen(buffer), 1, stream);
+MYTOML_API TomlKey *toml_loads_n(const char *buf, size_t len) {
+    Input input = {.type = I_STREAM, .stream = buf, .size = len, .owned = false};
+    return _mytoml_load(_mytoml_new_tokenizer(input));
 };
 
-MYTOML_API void toml_value_dump_file(TomlValue *object, FILE *file) { fprintf(file, "%s", toml_value_dumps(object)); };
+MYTOML_API TomlKey *toml_parse_ex(const char *buf, size_t len, TomlError_t *err) {
+    TomlError_t error;
+    Input input = {.type = I_STREAM, .stream = buf, .size = len, .owned = false};
+    return _mytoml_parse(_mytoml_new_tokenizer(input), err ? err : &error);
+};
 
-MYTOML_API void toml_value_dump_file_name(TomlValue *object, const char *file) {
-    FILE *stream;
-    stream = fopen(file, "w");
-    const char *buffer = toml_value_dumps(object);
-    fwrite(buffer, strlen(buffer), 1, stream);
+MYTOML_API TomlKey *toml_parse_parallel(const char *buf, size_t len, int threads, TomlError_t *err) {
+#if MYTOML_USE_THREADS
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    // sysconf() reports -1 when the count is unknown
+    if (threads <= 0) threads = 1;
+    // every thread gets at least `MYTOML_PARALLEL_CHUNK_SIZE` bytes
+    size_t chunks = len / MYTOML_PARALLEL_CHUNK_SIZE;
+    if ((size_t)threads > chunks) threads = (int)chunks;
+    bool parallel = threads > 1 && len < MYTOML_MAX_FILE_SIZE;
+    TomlKey *root = parallel ? _mytoml_parse_parallel(buf, len, threads) : NULL;
+    if (root) {
+        if (err) *err = (TomlError_t){TOML_OK, NULL, 0, 0};
+        return root;
+    }
+#else
+    (void)threads;
+#endif  // MYTOML_USE_THREADS
+    return toml_parse_ex(buf, len, err);
 };
 
-MYTOML_API const char *toml_key_dumps(TomlKey *k) {
-    char *buffer = "";
-    size_t size = 0;
-    toml_key_dump_buffer(k, &buffer, &size);
-    return buffer;
+MYTOML_API TomlStream *toml_stream_new(void) {
+    TomlStream *stream = (TomlStream *)calloc(1, sizeof(TomlStream));
+    if (stream == NULL) return NULL;
+    Input input = {.type = I_STREAM, .stream = NULL, .size = 0, .owned = false};
+    stream->tok = _mytoml_new_tokenizer(input);
+    stream->root = stream->tok ? _mytoml_new_root(stream->tok) : NULL;
+    if (stream->root == NULL) {
+        if (stream->tok) _mytoml_tokenizer_delete(stream->tok);
+        free(stream);
+        return NULL;
+    }
+    stream->table = stream->root;
+    return stream;
+}
+
+MYTOML_API bool toml_stream_feed(TomlStream *stream, const char *chunk, size_t len) {
+    if (stream == NULL || stream->root == NULL) return false;
+    if (len >= MYTOML_MAX_FILE_SIZE) {
+        stream->tok->error = (TomlError_t){TOML_MEMORY, "input size is too big", stream->line + 1, 1};
+        return _mytoml_stream_fail(stream);
+    }
+    size_t pos = 0;
+    // complete the statement held from the last piece line by line
+    while (stream->len > 0 && pos < len) {
+        const char *nl = (const char *)memchr(chunk + pos, '\n', len - pos);
+        size_t end = nl ? (size_t)(nl - chunk) + 1 : len;
+        if (!_mytoml_stream_carry(stream, chunk + pos, end - pos)) return false;
+        pos = end;
+        if (nl == NULL) break;
+        stream->scanned = _mytoml_scan_line(stream->carry, stream->scanned, stream->len, &stream->depth, &stream->quote);
+        stream->lines++;
+        if (stream->depth == 0 && stream->quote == 0) {
+            if (!_mytoml_stream_parse(stream, stream->carry, stream->len, stream->lines)) return false;
+            stream->len = 0;
+            stream->scanned = 0;
+            stream->lines = 0;
+        }
+    }
+    if (stream->len > 0) return true;
+
+    // then parse all whole statements straight from `chunk`
+    size_t line = pos, done = pos;
+    int lines = 0, done_lines = 0;
+    int depth = 0;
+    char quote = 0;
+    while (true) {
+        int d = depth;
+        char q = quote;
+        size_t next = _mytoml_scan_line(chunk, line, len, &d, &q);
+        if (next == 0) break;
+        line = next;
+        lines++;
+        depth = d;
+        quote = q;
+        if (depth == 0 && quote == 0) {
+            done = line;
+            done_lines = lines;
+        }
+    }
+    if (done > pos && !_mytoml_stream_parse(stream, chunk + pos, done - pos, done_lines)) return false;
+    // what is left is held along with how far it was scanned
+    if (!_mytoml_stream_carry(stream, chunk + done, len - done)) return false;
+    stream->scanned = line - done;
+    stream->lines = lines - done_lines;
+    stream->depth = depth;
+    stream->quote = quote;
+    return true;
 };
 
-MYTOML_API const char *toml_value_dumps(TomlValue *v) {
-    char *buffer = "";
-    size_t size = 0;
-    toml_value_dump_buffer(v, &buffer, &size);
-    return buffer;
+MYTOML_API TomlKey *toml_stream_finish(TomlStream *stream, TomlError_t *err) {
+    TomlError_t error;
+    if (err == NULL) err = &error;
+    if (stream == NULL) {
+        *err = (TomlError_t){TOML_MEMORY, "could not allocate stream", 0, 0};
+        return NULL;
+    }
+    // the last statement may end without a newline
+    if (stream->root && stream->len > 0) {
+        _mytoml_stream_parse(stream, stream->carry, stream->len, stream->lines);
+    }
+    TomlKey *root = stream->root;
+    if (root == NULL && stream->tok->error.type == TOML_OK) {
+        stream->tok->error = (TomlError_t){TOML_UNKNOWN, "unknown error", 0, 0};
+    }
+    *err = stream->tok->error;
+    _mytoml_tokenizer_delete(stream->tok);
+    free(stream->carry);
+    free(stream);
+    return root;
 };
 
-MYTOML_API void toml_key_dump_buffer(TomlKey *k, char **buffer, size_t *size) {
+static void _mytoml_value_dump(Writer *w, TomlValue *v);
+
+/*
+    Functions `_mytoml_key_dump` and `_mytoml_value_dump` write
+    the toml-test JSON form of a key or value into `w`. The
+    public dump functions wrap them around a caller's buffer.
+*/
+static void _mytoml_key_dump(Writer *w, TomlKey *k) {
     if (k->type == TOML_KEYLEAF && k->value != NULL && k->value->type != TOML_INLINETABLE) {
-        _mytoml_append_to_buffer(buffer, size, "\"");
-        _mytoml_string_dump(k->id, buffer, size);
-        _mytoml_append_to_buffer(buffer, size, "\": ");
-        toml_value_dump_buffer(k->value, buffer, size);
+        WRITE_LITERAL(w, "\"");
+        _mytoml_writer_escape(w, k->id, ID_LENGTH(k->id));
+        WRITE_LITERAL(w, "\": ");
+        _mytoml_value_dump(w, k->value);
     } else if (k->type == TOML_ARRAYTABLE) {
-        _mytoml_append_to_buffer(buffer, size, "\"");
-        _mytoml_string_dump(k->id, buffer, size);
-        _mytoml_append_to_buffer(buffer, size, "\": [\n");
-        for (size_t i = 0; i <= k->idx; i++) {
-            toml_value_dump_buffer(k->value->arr[i], buffer, size);
+        WRITE_LITERAL(w, "\"");
+        _mytoml_writer_escape(w, k->id, ID_LENGTH(k->id));
+        WRITE_LITERAL(w, "\": [\n");
+        for (size_t i = 0; k->idx != TOML_KEY_NO_INDEX && i <= k->idx; i++) {
+            _mytoml_value_dump(w, k->value->arr[i]);
             if (i != k->idx) {
-                _mytoml_append_to_buffer(buffer, size, ",\n");
+                WRITE_LITERAL(w, ",\n");
             }
         }
-        _mytoml_append_to_buffer(buffer, size, "\n]");
+        WRITE_LITERAL(w, "\n]");
     } else {
-        _mytoml_append_to_buffer(buffer, size, "\"");
-        _mytoml_string_dump(k->id, buffer, size);
-
-        _mytoml_append_to_buffer(buffer, size, "\": {\n");
-        int total = kh_size(k->subkeys);
-        for (khiter_t ki = kh_begin(k->subkeys); ki != kh_end(k->subkeys); ++ki) {
-            if (kh_exist(k->subkeys, ki)) {
-                toml_key_dump_buffer(kh_value(k->subkeys, ki), buffer, size);
-                if (--total > 0) {
-                    _mytoml_append_to_buffer(buffer, size, ",\n");
-                }
+        WRITE_LITERAL(w, "\"");
+        _mytoml_writer_escape(w, k->id, ID_LENGTH(k->id));
+
+        WRITE_LITERAL(w, "\": {\n");
+        for (int i = 0; i < k->subkeys.len; i++) {
+            _mytoml_key_dump(w, k->subkeys.entry[i].key);
+            if (i != k->subkeys.len - 1) {
+                WRITE_LITERAL(w, ",\n");
             }
         }
-        _mytoml_append_to_buffer(buffer, size, "\n}");
+        WRITE_LITERAL(w, "\n}");
     }
 }
 
-MYTOML_API void toml_value_dump_buffer(TomlValue *v, char **buffer, size_t *size) {
+static void _mytoml_value_dump(Writer *w, TomlValue *v) {
     switch (v->type) {
         case TOML_STRING: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"string\", \"value\": ");
-            _mytoml_string_dump((char *)v->data, buffer, size);
-            _mytoml_append_to_buffer(buffer, size, "\"}");
+            WRITE_LITERAL(w, "{\"type\": \"string\", \"value\": \"");
+            _mytoml_writer_escape(w, v->str, v->len);
+            WRITE_LITERAL(w, "\"}");
             break;
         }
         case TOML_FLOAT: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"float\", \"value\": ");
-            double f = *(double *)(v->data);
+            WRITE_LITERAL(w, "{\"type\": \"float\", \"value\": ");
+            double f = v->number;
             if (f == (double)INFINITY) {
-                _mytoml_append_to_buffer(buffer, size, "\"}");
-                _mytoml_append_to_buffer(buffer, size, "\"inf\"}");
+                WRITE_LITERAL(w, "\"inf\"}");
             } else if (f == (double)-INFINITY) {
-                _mytoml_append_to_buffer(buffer, size, "\"-inf\"}");
+                WRITE_LITERAL(w, "\"-inf\"}");
             } else if (isnan(f)) {
-                _mytoml_append_to_buffer(buffer, size, "\"nan\"}");
-            } else if (v->scientific) {
-                _mytoml_append_to_buffer(buffer, size, "\"%g\"}", f);
-            } else if (f == 0.0) {
-                _mytoml_append_to_buffer(buffer, size, "\"0.0\"}");
+                WRITE_LITERAL(w, "\"nan\"}");
             } else {
-                _mytoml_append_to_buffer(buffer, size, "\"%.*lf\"}", (int)v->precision, f);
+                WRITE_LITERAL(w, "\"");
+                _mytoml_writer_float(w, f);
+                WRITE_LITERAL(w, "\"}");
             }
             break;
         }
         case TOML_INT: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"integer\", \"value\": ");
-            _mytoml_append_to_buffer(buffer, size, "\"%.0lf\"}", *(double *)(v->data));
+            WRITE_LITERAL(w, "{\"type\": \"integer\", \"value\": ");
+            WRITE_LITERAL(w, "\"");
+            _mytoml_writer_integer(w, v->integer);
+            WRITE_LITERAL(w, "\"}");
             break;
         }
         case TOML_BOOL: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"bool\", \"value\": ");
-            if (*(double *)(v->data)) {
-                _mytoml_append_to_buffer(buffer, size, "\"true\"}");
+            WRITE_LITERAL(w, "{\"type\": \"bool\", \"value\": ");
+            if (v->boolean) {
+                WRITE_LITERAL(w, "\"true\"}");
             } else {
-                _mytoml_append_to_buffer(buffer, size, "\"false\"}");
+                WRITE_LITERAL(w, "\"false\"}");
             }
             break;
         }
         case TOML_DATETIME: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"datetime\", \"value\": ");
-            char buf[255] = {0};
-            strftime(buf, sizeof(buf), v->format, (struct tm *)v->data);
-            _mytoml_append_to_buffer(buffer, size, "\"%s\"}", buf);
+            WRITE_LITERAL(w, "{\"type\": \"datetime\", \"value\": ");
+            WRITE_LITERAL(w, "\"");
+            _mytoml_datetime_dump(w, v, 3);
+            WRITE_LITERAL(w, "\"}");
             break;
         }
         case TOML_DATETIMELOCAL: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"datetime-local\", \"value\": ");
-            char buf[255] = {0};
-            strftime(buf, sizeof(buf), v->format, (struct tm *)v->data);
-            _mytoml_append_to_buffer(buffer, size, "\"%s\"}", buf);
+            WRITE_LITERAL(w, "{\"type\": \"datetime-local\", \"value\": ");
+            WRITE_LITERAL(w, "\"");
+            _mytoml_datetime_dump(w, v, 3);
+            WRITE_LITERAL(w, "\"}");
             break;
         }
         case TOML_DATELOCAL: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"date-local\", \"value\": ");
-            char buf[255] = {0};
-            strftime(buf, sizeof(buf), v->format, (struct tm *)v->data);
-            _mytoml_append_to_buffer(buffer, size, "\"%s\"}", buf);
+            WRITE_LITERAL(w, "{\"type\": \"date-local\", \"value\": ");
+            WRITE_LITERAL(w, "\"");
+            _mytoml_datetime_dump(w, v, 3);
+            WRITE_LITERAL(w, "\"}");
             break;
         }
         case TOML_TIMELOCAL: {
-            _mytoml_append_to_buffer(buffer, size, "{\"type\": \"time-local\", \"value\": ");
-            char buf[255] = {0};
-            strftime(buf, sizeof(buf), v->format, (struct tm *)v->data);
-            _mytoml_append_to_buffer(buffer, size, "\"%s\"}", buf);
+            WRITE_LITERAL(w, "{\"type\": \"time-local\", \"value\": ");
+            WRITE_LITERAL(w, "\"");
+            _mytoml_datetime_dump(w, v, 3);
+            WRITE_LITERAL(w, "\"}");
             break;
         }
         case TOML_ARRAY: {
-            _mytoml_append_to_buffer(buffer, size, "[\n");
-            for (TomlValue **iter = v->arr; *iter != NULL; iter++) {
-                toml_value_dump_buffer(*iter, buffer, size);
-                if (*(iter + 1) != NULL) {
-                    _mytoml_append_to_buffer(buffer, size, ",\n");
+            WRITE_LITERAL(w, "[\n");
+            for (int i = 0; i < v->len; i++) {
+                _mytoml_value_dump(w, v->arr[i]);
+                if (i != v->len - 1) {
+                    WRITE_LITERAL(w, ",\n");
                 }
             }
-            _mytoml_append_to_buffer(buffer, size, "\n]");
+            WRITE_LITERAL(w, "\n]");
             break;
         }
         case TOML_INLINETABLE: {
-            _mytoml_append_to_buffer(buffer, size, "{\n");
-            TomlKey *k = (TomlKey *)(v->data);
-            int total = kh_size(k->subkeys);
-            for (khiter_t ki = kh_begin(k->subkeys); ki != kh_end(k->subkeys); ++ki) {
-                if (kh_exist(k->subkeys, ki)) {
-                    toml_key_dump_buffer(kh_value(k->subkeys, ki), buffer, size);
-                    if (--total > 0) {
-                        _mytoml_append_to_buffer(buffer, size, ",\n");
-                    }
+            WRITE_LITERAL(w, "{\n");
+            TomlKey *k = v->table;
+            for (int i = 0; i < k->subkeys.len; i++) {
+                _mytoml_key_dump(w, k->subkeys.entry[i].key);
+                if (i != k->subkeys.len - 1) {
+                    WRITE_LITERAL(w, ",\n");
                 }
             }
-            _mytoml_append_to_buffer(buffer, size, "\n}");
+            WRITE_LITERAL(w, "\n}");
             break;
         }
         default:
@@ -2657,52 +4344,411 @@ MYTOML_API void toml_value_dump_buffer(TomlValue *v, char **buffer, size_t *size
     }
 }
 
-MYTOML_API void toml_json_dump(TomlKey *root) {
-    printf("{\n");
-    int total = kh_size(root->subkeys);
-    for (khiter_t ki = kh_begin(root->subkeys); ki != kh_end(root->subkeys); ki++) {
-        if (kh_exist(root->subkeys, ki)) {
-            // toml_key_dump_buffer(kh_value(root->subkeys, ki),buffer,size);
-            if (--total > 0) {
-                printf(",\n");
+/*
+    Function `_mytoml_toml_id` writes the `n` bytes of `id` as
+    a bare key when they only hold bare key characters and
+    as a quoted key otherwise.
+*/
+static void _mytoml_toml_id(Writer *w, const char *id, size_t n) {
+    size_t i = 0;
+    while (i < n && _mytoml_is_bare_ascii(id[i])) i++;
+    if (n > 0 && i == n) {
+        _mytoml_writer_write(w, id, n);
+        return;
+    }
+    WRITE_LITERAL(w, "\"");
+    _mytoml_writer_escape(w, id, n);
+    WRITE_LITERAL(w, "\"");
+}
+
+/*
+    Function `_mytoml_toml_path` writes the keys of `path`
+    joined by dots, outermost first.
+*/
+static void _mytoml_toml_path(Writer *w, const KeyPath *path) {
+    if (path->parent != NULL) {
+        _mytoml_toml_path(w, path->parent);
+        WRITE_LITERAL(w, ".");
+    }
+    _mytoml_toml_id(w, path->key->id, ID_LENGTH(path->key->id));
+}
+
+/*
+    Function `_mytoml_toml_float` writes `f` as a TOML float.
+*/
+static void _mytoml_toml_float(Writer *w, double f) {
+    if (isnan(f)) {
+        WRITE_LITERAL(w, "nan");
+    } else if (isinf(f)) {
+        if (f < 0) WRITE_LITERAL(w, "-inf");
+        else WRITE_LITERAL(w, "inf");
+    } else {
+        _mytoml_writer_float(w, f);
+    }
+}
+
+static void _mytoml_toml_value(Writer *w, TomlValue *v);
+static void _mytoml_toml_pairs(Writer *w, const KeyPath *prefix, TomlKey *k, bool inline_table, bool *first);
+
+/*
+    Function `_mytoml_toml_inline` writes the pairs of `k` as
+    an inline table.
+*/
+static void _mytoml_toml_inline(Writer *w, TomlKey *k) {
+    bool first = true;
+    WRITE_LITERAL(w, "{");
+    _mytoml_toml_pairs(w, NULL, k, true, &first);
+    if (first) WRITE_LITERAL(w, "}");
+    else WRITE_LITERAL(w, " }");
+}
+
+static void _mytoml_toml_value(Writer *w, TomlValue *v) {
+    switch (v->type) {
+        case TOML_STRING:
+            WRITE_LITERAL(w, "\"");
+            _mytoml_writer_escape(w, v->str, v->len);
+            WRITE_LITERAL(w, "\"");
+            break;
+        case TOML_FLOAT:
+            _mytoml_toml_float(w, v->number);
+            break;
+        case TOML_INT:
+            _mytoml_writer_integer(w, v->integer);
+            break;
+        case TOML_BOOL:
+            if (v->boolean) WRITE_LITERAL(w, "true");
+            else WRITE_LITERAL(w, "false");
+            break;
+        case TOML_DATETIME:
+        case TOML_DATETIMELOCAL:
+        case TOML_DATELOCAL:
+        case TOML_TIMELOCAL:
+            _mytoml_datetime_dump(w, v, 0);
+            break;
+        case TOML_ARRAY:
+            WRITE_LITERAL(w, "[");
+            for (int i = 0; i < v->len; i++) {
+                if (i > 0) WRITE_LITERAL(w, ", ");
+                _mytoml_toml_value(w, v->arr[i]);
+            }
+            WRITE_LITERAL(w, "]");
+            break;
+        case TOML_INLINETABLE:
+            _mytoml_toml_inline(w, v->table);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+    Function `_mytoml_toml_pairs` writes every key/value pair
+    below `k`, descending into dotted keys and leaving tables
+    and arrays of tables to `_mytoml_toml_tables`. Pairs are
+    written one per line, or comma separated for an inline
+    table, in which case `first` tracks the separator.
+*/
+static void _mytoml_toml_pairs(Writer *w, const KeyPath *prefix, TomlKey *k, bool inline_table, bool *first) {
+    for (int i = 0; i < k->subkeys.len; i++) {
+        TomlKey *sub = k->subkeys.entry[i].key;
+        KeyPath path = {prefix, sub};
+        if (sub->type == TOML_KEY) {
+            _mytoml_toml_pairs(w, &path, sub, inline_table, first);
+            continue;
+        }
+        if (sub->type != TOML_KEYLEAF) continue;
+        if (inline_table && *first) WRITE_LITERAL(w, " ");
+        else if (inline_table) WRITE_LITERAL(w, ", ");
+        *first = false;
+        _mytoml_toml_path(w, &path);
+        WRITE_LITERAL(w, " = ");
+        // a leaf without a value holds the pairs of an inline table
+        if (sub->value != NULL) _mytoml_toml_value(w, sub->value);
+        else _mytoml_toml_inline(w, sub);
+        if (!inline_table) WRITE_LITERAL(w, "\n");
+    }
+}
+
+/*
+    Function `_mytoml_toml_tables` writes the tables and arrays
+    of tables below `k`, whose own path is `path`. A table gets
+    a `[header]` unless it only holds other tables.
+*/
+static void _mytoml_toml_tables(Writer *w, const KeyPath *path, TomlKey *k) {
+    for (int i = 0; i < k->subkeys.len; i++) {
+        TomlKey *sub = k->subkeys.entry[i].key;
+        KeyPath subpath = {path, sub};
+        switch (sub->type) {
+            case TOML_KEY:
+                _mytoml_toml_tables(w, &subpath, sub);
+                break;
+            case TOML_TABLE:
+            case TOML_TABLELEAF: {
+                bool pairs = false, tables = false;
+                for (int j = 0; j < sub->subkeys.len; j++) {
+                    TomlKeyType type = sub->subkeys.entry[j].key->type;
+                    if (type == TOML_KEY || type == TOML_KEYLEAF) pairs = true;
+                    else tables = true;
+                }
+                if (pairs || !tables) {
+                    if (w->flushed + w->len > 0) WRITE_LITERAL(w, "\n");
+                    WRITE_LITERAL(w, "[");
+                    _mytoml_toml_path(w, &subpath);
+                    WRITE_LITERAL(w, "]\n");
+                    bool first = true;
+                    _mytoml_toml_pairs(w, NULL, sub, false, &first);
+                }
+                _mytoml_toml_tables(w, &subpath, sub);
+                break;
             }
+            case TOML_ARRAYTABLE:
+                for (int j = 0; j < sub->value->len; j++) {
+                    TomlKey *element = sub->value->arr[j]->table;
+                    if (w->flushed + w->len > 0) WRITE_LITERAL(w, "\n");
+                    WRITE_LITERAL(w, "[[");
+                    _mytoml_toml_path(w, &subpath);
+                    WRITE_LITERAL(w, "]]\n");
+                    bool first = true;
+                    _mytoml_toml_pairs(w, NULL, element, false, &first);
+                    _mytoml_toml_tables(w, &subpath, element);
+                }
+                break;
+            default:
+                break;
         }
     }
-    printf("\n}\n");
 }
 
-MYTOML_API void toml_free(TomlKey *toml) { _mytoml_value_delete_key(toml); }
+/*
+    Function `_mytoml_toml_dump` writes `root` as a TOML
+    document: its own pairs first, then its tables.
+*/
+static void _mytoml_toml_dump(Writer *w, TomlKey *root) {
+    bool first = true;
+    _mytoml_toml_pairs(w, NULL, root, false, &first);
+    _mytoml_toml_tables(w, NULL, root);
+}
+
+static void _mytoml_json_value(Writer *w, TomlValue *v);
+
+/*
+    Function `_mytoml_json_object` writes the subkeys of `k` as
+    a JSON object. Dotted keys, tables and inline tables all
+    become nested objects, and arrays of tables arrays of them.
+*/
+static void _mytoml_json_object(Writer *w, TomlKey *k) {
+    bool first = true;
+    WRITE_LITERAL(w, "{");
+    for (int i = 0; i < k->subkeys.len; i++) {
+        TomlKey *sub = k->subkeys.entry[i].key;
+        if (!first) WRITE_LITERAL(w, ", ");
+        first = false;
+        WRITE_LITERAL(w, "\"");
+        _mytoml_writer_escape(w, sub->id, ID_LENGTH(sub->id));
+        WRITE_LITERAL(w, "\": ");
+        if (sub->value != NULL) _mytoml_json_value(w, sub->value);
+        else _mytoml_json_object(w, sub);
+    }
+    WRITE_LITERAL(w, "}");
+}
+
+static void _mytoml_json_value(Writer *w, TomlValue *v) {
+    switch (v->type) {
+        case TOML_STRING:
+            WRITE_LITERAL(w, "\"");
+            _mytoml_writer_escape(w, v->str, v->len);
+            WRITE_LITERAL(w, "\"");
+            break;
+        case TOML_FLOAT:
+            // JSON has no inf or nan
+            if (isfinite(v->number)) _mytoml_writer_float(w, v->number);
+            else WRITE_LITERAL(w, "null");
+            break;
+        case TOML_INT:
+            _mytoml_writer_integer(w, v->integer);
+            break;
+        case TOML_BOOL:
+            if (v->boolean) WRITE_LITERAL(w, "true");
+            else WRITE_LITERAL(w, "false");
+            break;
+        case TOML_DATETIME:
+        case TOML_DATETIMELOCAL:
+        case TOML_DATELOCAL:
+        case TOML_TIMELOCAL:
+            WRITE_LITERAL(w, "\"");
+            _mytoml_datetime_dump(w, v, 0);
+            WRITE_LITERAL(w, "\"");
+            break;
+        case TOML_ARRAY:
+            WRITE_LITERAL(w, "[");
+            for (int i = 0; i < v->len; i++) {
+                if (i > 0) WRITE_LITERAL(w, ", ");
+                _mytoml_json_value(w, v->arr[i]);
+            }
+            WRITE_LITERAL(w, "]");
+            break;
+        case TOML_INLINETABLE:
+            _mytoml_json_object(w, v->table);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+    Functions `_mytoml_file_write` and `_mytoml_fd_write` are
+    the sinks behind the `FILE *` and file descriptor dumps.
+*/
+static size_t _mytoml_file_write(const char *data, size_t size, void *user) { return fwrite(data, 1, size, (FILE *)user); }
+
+static size_t _mytoml_fd_write(const char *data, size_t size, void *user) {
+    int fd = *(int *)user;
+    size_t done = 0;
+    while (done < size) {
+#if MYTOML_PLATFORM_IS(WINDOWS)
+        int n = _write(fd, data + done, (unsigned int)(size - done));
+#else
+        ssize_t n = write(fd, data + done, size - done);
+#endif
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    return done;
+}
+
+MYTOML_API bool toml_key_dump_file(TomlKey *object, FILE *file) { return toml_key_dump_callback(object, _mytoml_file_write, file); };
+
+MYTOML_API bool toml_key_dump_file_name(TomlKey *object, const char *file) {
+    FILE *stream = fopen(file, "w");
+    if (stream == NULL) return false;
+    bool ok = toml_key_dump_file(object, stream);
+    return (fclose(stream) == 0) && ok;
+};
+
+MYTOML_API bool toml_value_dump_file(TomlValue *object, FILE *file) { return toml_value_dump_callback(object, _mytoml_file_write, file); };
+
+MYTOML_API bool toml_value_dump_file_name(TomlValue *object, const char *file) {
+    FILE *stream = fopen(file, "w");
+    if (stream == NULL) return false;
+    bool ok = toml_value_dump_file(object, stream);
+    return (fclose(stream) == 0) && ok;
+};
+
+MYTOML_API bool toml_key_dump_fd(TomlKey *object, int fd) { return toml_key_dump_callback(object, _mytoml_fd_write, &fd); };
+
+MYTOML_API bool toml_value_dump_fd(TomlValue *object, int fd) { return toml_value_dump_callback(object, _mytoml_fd_write, &fd); };
+
+MYTOML_API bool toml_key_dump_callback(TomlKey *object, TomlWriteCallback write, void *user) {
+    char staging[MYTOML_WRITER_STAGING_SIZE];
+    Writer w = {.data = staging, .cap = sizeof(staging), .sink = write, .user = user};
+    _mytoml_key_dump(&w, object);
+    return _mytoml_writer_flush(&w);
+};
+
+MYTOML_API bool toml_value_dump_callback(TomlValue *object, TomlWriteCallback write, void *user) {
+    char staging[MYTOML_WRITER_STAGING_SIZE];
+    Writer w = {.data = staging, .cap = sizeof(staging), .sink = write, .user = user};
+    _mytoml_value_dump(&w, object);
+    return _mytoml_writer_flush(&w);
+};
+
+MYTOML_API const char *toml_key_dumps(TomlKey *k) {
+    char *buffer = NULL;
+    size_t size = 0;
+    toml_key_dump_buffer(k, &buffer, &size);
+    return buffer;
+};
+
+MYTOML_API const char *toml_value_dumps(TomlValue *v) {
+    char *buffer = NULL;
+    size_t size = 0;
+    toml_value_dump_buffer(v, &buffer, &size);
+    return buffer;
+};
+
+MYTOML_API void toml_key_dump_buffer(TomlKey *k, char **buffer, size_t *size) {
+    Writer w = {.data = *buffer, .len = *size, .cap = *size};
+    _mytoml_key_dump(&w, k);
+    _mytoml_writer_take(&w, buffer, size);
+}
+
+MYTOML_API void toml_value_dump_buffer(TomlValue *v, char **buffer, size_t *size) {
+    Writer w = {.data = *buffer, .len = *size, .cap = *size};
+    _mytoml_value_dump(&w, v);
+    _mytoml_writer_take(&w, buffer, size);
+}
+
+MYTOML_API void toml_key_dump(TomlKey *root) { toml_key_dump_toml_callback(root, _mytoml_file_write, stdout); }
+
+MYTOML_API void toml_key_dump_toml_buffer(TomlKey *root, char **buffer, size_t *size) {
+    Writer w = {.data = *buffer, .len = *size, .cap = *size};
+    _mytoml_toml_dump(&w, root);
+    _mytoml_writer_take(&w, buffer, size);
+}
+
+MYTOML_API bool toml_key_dump_toml_callback(TomlKey *root, TomlWriteCallback write, void *user) {
+    char staging[MYTOML_WRITER_STAGING_SIZE];
+    Writer w = {.data = staging, .cap = sizeof(staging), .sink = write, .user = user};
+    _mytoml_toml_dump(&w, root);
+    return _mytoml_writer_flush(&w);
+}
 
-MYTOML_API int *toml_get_int(TomlKey *key) {
+MYTOML_API void toml_json_dump(TomlKey *root) {
+    toml_key_dump_json_callback(root, _mytoml_file_write, stdout);
+    putchar('\n');
+}
+
+MYTOML_API void toml_key_dump_json_buffer(TomlKey *root, char **buffer, size_t *size) {
+    Writer w = {.data = *buffer, .len = *size, .cap = *size};
+    _mytoml_json_object(&w, root);
+    _mytoml_writer_take(&w, buffer, size);
+}
+
+MYTOML_API bool toml_key_dump_json_callback(TomlKey *root, TomlWriteCallback write, void *user) {
+    char staging[MYTOML_WRITER_STAGING_SIZE];
+    Writer w = {.data = staging, .cap = sizeof(staging), .sink = write, .user = user};
+    _mytoml_json_object(&w, root);
+    return _mytoml_writer_flush(&w);
+}
+
+MYTOML_API void toml_free(TomlKey *toml) {
+    if (toml == NULL) return;
+    TomlDocument *doc = DOCUMENT_OF(toml);
+    if (doc->arena) {
+        _mytoml_arena_delete(doc->arena);
+        return;
+    }
+    TomlArena *ids = doc->ids;
+    _mytoml_value_delete_key(NULL, toml);
+    _mytoml_arena_delete(ids);
+}
+
+MYTOML_API int64_t *toml_get_int(TomlKey *key) {
     if (!key) return NULL;
     if (!(key->value)) return NULL;
     if (!(key->value->type == TOML_INT)) return NULL;
-    if (!(key->value->data)) return NULL;
-    return (int *)(key->value->data);
+    return &key->value->integer;
 }
 
 MYTOML_API bool *toml_get_bool(TomlKey *key) {
     if (!key) return NULL;
     if (!(key->value)) return NULL;
     if (!(key->value->type == TOML_BOOL)) return NULL;
-    if (!(key->value->data)) return NULL;
-    return (bool *)(key->value->data);
+    return &key->value->boolean;
 }
 
 MYTOML_API char *toml_get_string(TomlKey *key) {
     if (!key) return NULL;
     if (!(key->value)) return NULL;
     if (!(key->value->type == TOML_STRING)) return NULL;
-    if (!(key->value->data)) return NULL;
-    return (char *)(key->value->data);
+    return key->value->str;
 }
 
 MYTOML_API double *toml_get_float(TomlKey *key) {
     if (!key) return NULL;
     if (!(key->value)) return NULL;
     if (!(key->value->type == TOML_FLOAT)) return NULL;
-    if (!(key->value->data)) return NULL;
-    return (double *)(key->value->data);
+    return &key->value->number;
 }
 
 MYTOML_API TomlValue *toml_get_array(TomlKey *key) {
@@ -2712,14 +4758,20 @@ MYTOML_API TomlValue *toml_get_array(TomlKey *key) {
     return key->value;
 }
 
-MYTOML_API struct tm *toml_get_datetime(TomlKey *key) {
+MYTOML_API TomlDatetime *toml_get_datetime(TomlKey *key) {
     if (!key) return NULL;
     if (!(key->value)) return NULL;
     if (!(key->value->type == TOML_DATETIME || key->value->type == TOML_DATETIMELOCAL || key->value->type == TOML_DATELOCAL ||
           key->value->type == TOML_TIMELOCAL))
         return NULL;
-    if (!(key->value->data)) return NULL;
-    return (struct tm *)(key->value->data);
+    return &key->value->datetime;
+}
+
+MYTOML_API int toml_key_count(const TomlKey *key) { return (key != NULL) ? key->subkeys.len : 0; }
+
+MYTOML_API TomlKey *toml_key_at(const TomlKey *key, int index) {
+    if (key == NULL || index < 0 || index >= key->subkeys.len) return NULL;
+    return key->subkeys.entry[index].key;
 }
 
 MYTOML_API TomlKey *toml_get_key(TomlKey *key, const char *id) {
@@ -2729,14 +4781,52 @@ MYTOML_API TomlKey *toml_get_key(TomlKey *key, const char *id) {
     if (strcmp(key->id, id) == 0) {
         return key;
     }
-    khiter_t k = kh_get(str, key->subkeys, id);
-    if (k != kh_end(key->subkeys)) {
-        return kh_value(key->subkeys, k);
+    // a missing key is an answer, not an error
+    size_t length = strlen(id);
+    return _mytoml_value_find_sub_key(key, id, length, _mytoml_hash(id, length));
+}
+
+MYTOML_API TomlKey *toml_get_path(TomlKey *root, const char *path) {
+    TomlPath *p = toml_path_compile(path);
+    if (p == NULL) return NULL;
+    TomlKey *k = toml_path_get(root, p);
+    toml_path_free(p);
+    return k;
+}
+
+MYTOML_API TomlPath *toml_path_compile(const char *path) {
+    if (path == NULL) return NULL;
+    int n = _mytoml_path_parse(path, NULL, NULL);
+    if (n < 0) return NULL;
+    // the unescaped keys never outgrow the path they came from
+    size_t size = sizeof(TomlPath) + n * sizeof(PathSegment) + strlen(path) + n;
+    TomlPath *p = (TomlPath *)malloc(size);
+    if (p == NULL) return NULL;
+    p->len = n;
+    _mytoml_path_parse(path, p->segment, (char *)(p->segment + n));
+    return p;
+}
+
+MYTOML_API TomlKey *toml_path_get(TomlKey *root, const TomlPath *path) {
+    if (path == NULL) return NULL;
+    TomlKey *k = root;
+    for (int i = 0; i < path->len && k != NULL; i++) {
+        const PathSegment *s = &path->segment[i];
+        if (s->id != NULL) {
+            k = _mytoml_value_find_sub_key(k, s->id, s->length, s->hash);
+            continue;
+        }
+        // arrays of tables and arrays of inline tables can be indexed
+        TomlValue *a = k->value;
+        if (a == NULL || a->type != TOML_ARRAY || s->index >= (size_t)a->len) return NULL;
+        TomlValue *e = a->arr[s->index];
+        k = (e->type == TOML_INLINETABLE) ? e->table : NULL;
     }
-    LOG_ERR("node %s does not exist in subkeys of node %s", id, key->id);
-    return NULL;
+    return k;
 }
 
+MYTOML_API void toml_path_free(TomlPath *path) { free(path); }
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -0,0 +1,75 @@
+/**
+ * Documents are released as a whole, whether or not they were
+ * parsed into an arena. The test suite runs every behaviour test
+ * against both builds, see `MYTOML_USE_ARENA`.
+ */
+
+#include <stddef.h>
+
+#include "mytoml_test.h"
+
+static const char *documents[] = {
+    "a = 1\n",
+    "[t]\na = \"x\"\nb = [1, [2, {c = 3}]]\n[[u]]\nd = 1979-05-27T07:32:00Z\n[[u]]\ne = 1.5\n",
+    "a = {b = {c = {d = [\"\"\"x\ny\"\"\", '''z''']}}}\n",
+};
+
+/* Invalid documents failing after part of the tree was built. */
+static const char *invalid[] = {
+    "a = 1\nb = [1, 2, {c = 3}, \"x\"\nd = 2\n",
+    "[t]\na = \"x\"\n[[u]]\nb = 1\n[t]\n",
+    "a = {b = 1, b = 2}\n",
+    "a = \"x\"\nb = \"\"\"y\n",
+    "a.b.c = 1\na.b = 2\n",
+};
+
+static void test_documents(void) {
+    for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+        // every copy owns its memory, so freeing one leaves the others intact
+        TomlKey *a = test_parse(documents[i]);
+        TomlKey *b = test_parse(documents[i]);
+        CHECK(a != NULL && b != NULL);
+        toml_free(a);
+        CHECK(toml_key_count(b) > 0);
+        toml_free(b);
+    }
+    TomlKey *root = test_parse(documents[1]);
+    CHECK_STRING(root, "t.a", "x");
+    CHECK_FLOAT(root, "u[1].e", 1.5);
+    toml_free(root);
+    toml_free(NULL);
+}
+
+static void test_invalid_documents(void) {
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        CHECK(!test_valid(invalid[i]));
+    }
+}
+
+static void test_large_document(void) {
+    // spans many arena chunks
+    int n = 20000;
+    char *doc = (char *)malloc((size_t)n * 48);
+    int len = 0;
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "[t%d]\ns = \"value %d\"\na = [%d]\n", i, i, i);
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    CHECK(toml_key_count(root) == n);
+    CHECK_STRING(root, "t0.s", "value 0");
+    CHECK_STRING(root, "t19999.s", "value 19999");
+    toml_free(root);
+    free(doc);
+}
+
+static void test_key_layout(void) {
+    // what only the root owns is kept out of every other key
+    CHECK(sizeof(TomlKey) == offsetof(TomlKey, idx) + sizeof(size_t));
+}
+
+int main(void) {
+    test_key_layout();
+    test_documents();
+    test_invalid_documents();
+    test_large_document();
+    return TEST_RESULT();
+}
@@ -0,0 +1,88 @@
+/**
+ * Arrays grow on demand, so they have no length limit and small
+ * arrays only hold the slots they use.
+ */
+
+#include "mytoml_test.h"
+
+static void test_small_arrays(void) {
+    TomlKey *root = test_parse("a = []\nb = [80]\nc = [1, \"x\", [2, 3], {d = 4},]\ne = [\n  1,\n  # comment\n  2,\n]\n");
+    CHECK(root != NULL);
+    TomlValue *a = toml_get_array(toml_get_path(root, "a"));
+    CHECK(a != NULL && a->len == 0);
+    TomlValue *b = toml_get_array(toml_get_path(root, "b"));
+    CHECK(b != NULL && b->len == 1 && b->cap >= 1 && b->arr[0]->integer == 80);
+    TomlValue *c = toml_get_array(toml_get_path(root, "c"));
+    CHECK(c != NULL && c->len == 4);
+    if (c != NULL && c->len == 4) {
+        CHECK(c->arr[0]->type == TOML_INT && c->arr[0]->integer == 1);
+        CHECK(c->arr[1]->type == TOML_STRING && strcmp(c->arr[1]->str, "x") == 0);
+        CHECK(c->arr[2]->type == TOML_ARRAY && c->arr[2]->len == 2 && c->arr[2]->arr[1]->integer == 3);
+        CHECK(c->arr[3]->type == TOML_INLINETABLE);
+    }
+    TomlValue *e = toml_get_array(toml_get_path(root, "e"));
+    CHECK(e != NULL && e->len == 2 && e->arr[1]->integer == 2);
+    toml_free(root);
+    CHECK(!test_valid("a = [,]\n"));
+    CHECK(!test_valid("a = [1,,2]\n"));
+    CHECK(!test_valid("a = [1 2]\n"));
+    CHECK(!test_valid("a = [1\n"));
+}
+
+static void test_large_array(int n) {
+    char *doc = (char *)malloc((size_t)n * 12 + 16);
+    int len = sprintf(doc, "a = [");
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "%d,", i);
+    sprintf(doc + len, "]\n");
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    TomlValue *a = toml_get_array(toml_get_path(root, "a"));
+    CHECK(a != NULL && a->len == n && a->cap >= n);
+    for (int i = 0; a != NULL && i < a->len; i++) {
+        if (a->arr[i]->integer != i) {
+            CHECK(!"large array element out of order");
+            break;
+        }
+    }
+    toml_free(root);
+    free(doc);
+}
+
+static void test_nested_arrays(void) {
+    char doc[1024];
+    int depth = 200;
+    int len = sprintf(doc, "a = ");
+    for (int i = 0; i < depth; i++) doc[len++] = '[';
+    for (int i = 0; i < depth; i++) doc[len++] = ']';
+    sprintf(doc + len, "\n");
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    TomlValue *a = toml_get_array(toml_get_path(root, "a"));
+    for (int i = 1; a != NULL && i < depth; i++) {
+        CHECK(a->len == 1);
+        a = a->len == 1 ? a->arr[0] : NULL;
+    }
+    CHECK(a != NULL && a->type == TOML_ARRAY && a->len == 0);
+    toml_free(root);
+}
+
+static void test_array_tables(void) {
+    char doc[64 * 32];
+    int len = 0;
+    for (int i = 0; i < 64; i++) len += sprintf(doc + len, "[[t]]\nn = %d\n", i);
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    CHECK_INT(root, "t[0].n", 0);
+    CHECK_INT(root, "t[63].n", 63);
+    CHECK(toml_get_path(root, "t[64].n") == NULL);
+    toml_free(root);
+}
+
+int main(void) {
+    test_small_arrays();
+    test_large_array(1000);
+    test_large_array(200000);
+    test_nested_arrays();
+    test_array_tables();
+    return TEST_RESULT();
+}
@@ -0,0 +1,103 @@
+/**
+ * The streaming dumpers hand their output to a callback or a file
+ * descriptor one staging buffer at a time.
+ */
+
+#include "mytoml_test.h"
+
+typedef struct Sink {
+    char *data;
+    size_t len;
+    size_t calls;
+    size_t limit; /* bytes accepted before writes come up short */
+} Sink;
+
+static size_t test_sink(const char *data, size_t size, void *user) {
+    Sink *sink = (Sink *)user;
+    sink->calls++;
+    if (sink->len + size > sink->limit) return 0;
+    sink->data = (char *)realloc(sink->data, sink->len + size + 1);
+    memcpy(sink->data + sink->len, data, size);
+    sink->len += size;
+    sink->data[sink->len] = '\0';
+    return size;
+}
+
+static TomlKey *test_large_document(int n) {
+    char *doc = (char *)malloc((size_t)n * 32 + 16);
+    int len = sprintf(doc, "a = [");
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "\"value %d\",", i);
+    sprintf(doc + len, "]\n");
+    TomlKey *root = test_parse(doc);
+    free(doc);
+    return root;
+}
+
+static void test_callback(void) {
+    TomlKey *root = test_large_document(10000);
+    CHECK(root != NULL);
+    TomlKey *a = toml_get_path(root, "a");
+    char *want = (char *)toml_key_dumps(a);
+    Sink sink = {NULL, 0, 0, (size_t)-1};
+    CHECK(toml_key_dump_callback(a, test_sink, &sink));
+    CHECK(sink.calls > 1);
+    CHECK(want != NULL && sink.data != NULL && strcmp(sink.data, want) == 0);
+    free(sink.data);
+    free(want);
+
+    want = (char *)toml_value_dumps(a->value);
+    sink = (Sink){NULL, 0, 0, (size_t)-1};
+    CHECK(toml_value_dump_callback(a->value, test_sink, &sink));
+    CHECK(want != NULL && sink.data != NULL && strcmp(sink.data, want) == 0);
+    free(sink.data);
+    free(want);
+
+    // a short write stops the dump
+    sink = (Sink){NULL, 0, 0, 1000};
+    CHECK(!toml_key_dump_callback(a, test_sink, &sink));
+    CHECK(sink.calls == 1 && sink.len == 0);
+    free(sink.data);
+    toml_free(root);
+}
+
+static void test_small(void) {
+    TomlKey *root = test_parse("a = 1\n");
+    CHECK(root != NULL);
+    Sink sink = {NULL, 0, 0, (size_t)-1};
+    CHECK(toml_key_dump_callback(toml_get_path(root, "a"), test_sink, &sink));
+    CHECK(sink.calls == 1 && sink.data != NULL && strcmp(sink.data, "\"a\": {\"type\": \"integer\", \"value\": \"1\"}") == 0);
+    free(sink.data);
+    toml_free(root);
+}
+
+static void test_file(void) {
+    TomlKey *root = test_large_document(3000);
+    CHECK(root != NULL);
+    TomlKey *a = toml_get_path(root, "a");
+    char *want = (char *)toml_key_dumps(a);
+    FILE *file = tmpfile();
+    CHECK(file != NULL);
+    if (file != NULL && want != NULL) {
+        CHECK(toml_key_dump_fd(a, fileno(file)));
+        toml_key_dump_file(a, file);
+        fflush(file);
+        size_t len = strlen(want);
+        char *data = (char *)malloc(2 * len + 1);
+        rewind(file);
+        size_t n = fread(data, 1, 2 * len + 1, file);
+        // written once through the descriptor and once through the stream
+        CHECK(n == 2 * len && memcmp(data, want, len) == 0 && memcmp(data + len, want, len) == 0);
+        free(data);
+        fclose(file);
+    }
+    free(want);
+    CHECK(!toml_key_dump_fd(a, -1));
+    toml_free(root);
+}
+
+int main(void) {
+    test_callback();
+    test_small();
+    test_file();
+    return TEST_RESULT();
+}
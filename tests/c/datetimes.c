@@ -0,0 +1,108 @@
+/**
+ * Datetimes are parsed in a single pass into packed fields.
+ */
+
+#include "mytoml_test.h"
+
+static TomlValue *test_datetime(TomlKey *root, const char *path) {
+    TomlKey *key = toml_get_path(root, path);
+    CHECK(toml_get_datetime(key) != NULL);
+    return toml_get_datetime(key) ? key->value : NULL;
+}
+
+static void test_types(void) {
+    TomlKey *root = test_parse(
+        "odt = 1979-05-27T07:32:00Z\n"
+        "off = 1979-05-27T00:32:00.999999-07:30\n"
+        "space = 1979-05-27 07:32:00+01:00\n"
+        "lower = 1979-05-27t07:32:00z\n"
+        "ldt = 1979-05-27T07:32:00.5\n"
+        "ld = 1979-05-27\n"
+        "lt = 00:32:00.123456789\n"
+        "leap = 2000-02-29\n"
+        "leapsec = 1990-12-31T23:59:60Z\n"
+        "leaplt = 23:59:60.25\n");
+    CHECK(root != NULL);
+    TomlValue *v = test_datetime(root, "odt");
+    if (v != NULL) {
+        TomlDatetime *d = &v->datetime;
+        CHECK(v->type == TOML_DATETIME);
+        CHECK(d->year == 1979 && d->month == 5 && d->day == 27 && d->hour == 7 && d->minute == 32 && d->second == 0);
+        CHECK(d->offset == 0 && (d->flags & TOML_DATETIME_ZULU));
+    }
+    v = test_datetime(root, "off");
+    if (v != NULL) {
+        CHECK(v->type == TOML_DATETIME && v->datetime.offset == -450 && !(v->datetime.flags & TOML_DATETIME_ZULU));
+        CHECK(v->datetime.nanosecond == 999999000 && v->precision == 6);
+    }
+    v = test_datetime(root, "space");
+    CHECK(v != NULL && v->type == TOML_DATETIME && v->datetime.offset == 60 && v->datetime.hour == 7);
+    v = test_datetime(root, "lower");
+    CHECK(v != NULL && v->type == TOML_DATETIME && (v->datetime.flags & TOML_DATETIME_ZULU));
+    v = test_datetime(root, "ldt");
+    CHECK(v != NULL && v->type == TOML_DATETIMELOCAL && v->datetime.nanosecond == 500000000 && v->datetime.offset == 0);
+    CHECK(v != NULL && v->precision == 1);
+    v = test_datetime(root, "ld");
+    CHECK(v != NULL && v->type == TOML_DATELOCAL && v->datetime.day == 27 && v->datetime.hour == 0);
+    v = test_datetime(root, "lt");
+    CHECK(v != NULL && v->type == TOML_TIMELOCAL && v->datetime.year == 0 && v->datetime.minute == 32);
+    CHECK(v != NULL && v->datetime.nanosecond == 123456789 && v->precision == 9);
+    v = test_datetime(root, "leap");
+    CHECK(v != NULL && v->datetime.month == 2 && v->datetime.day == 29);
+    v = test_datetime(root, "leapsec");
+    CHECK(v != NULL && v->type == TOML_DATETIME && v->datetime.second == 60);
+    v = test_datetime(root, "leaplt");
+    CHECK(v != NULL && v->datetime.second == 60 && v->datetime.nanosecond == 250000000 && v->precision == 2);
+    toml_free(root);
+}
+
+static void test_fraction_digits(void) {
+    TomlKey *root = test_parse("a = 07:32:00.5\nb = 1979-05-27T07:32:00.12Z\nc = 07:32:00\n");
+    CHECK(root != NULL);
+    char *buffer = NULL;
+    size_t size = 0;
+    // fractions are written back with the digits they were read with
+    toml_key_dump_toml_buffer(root, &buffer, &size);
+    CHECK(buffer != NULL && strstr(buffer, "a = 07:32:00.5\n") != NULL);
+    CHECK(buffer != NULL && strstr(buffer, "b = 1979-05-27T07:32:00.12Z\n") != NULL);
+    CHECK(buffer != NULL && strstr(buffer, "c = 07:32:00\n") != NULL);
+    free(buffer);
+    buffer = NULL;
+    size = 0;
+    toml_key_dump_json_buffer(root, &buffer, &size);
+    CHECK(buffer != NULL && strstr(buffer, "\"07:32:00.5\"") != NULL);
+    free(buffer);
+    buffer = NULL;
+    size = 0;
+    // toml-test output carries at least milliseconds
+    toml_key_dump_buffer(root, &buffer, &size);
+    CHECK(buffer != NULL && strstr(buffer, "\"07:32:00.500\"") != NULL);
+    CHECK(buffer != NULL && strstr(buffer, "\"1979-05-27T07:32:00.120Z\"") != NULL);
+    CHECK(buffer != NULL && strstr(buffer, "\"07:32:00\"") != NULL);
+    free(buffer);
+    toml_free(root);
+}
+
+static void test_invalid(void) {
+    const char *invalid[] = {
+        "1979-05-27T07:32:00+",  "1979-13-01",          "1979-00-01",          "1979-04-31",          "1900-02-29",
+        "1979-05-27T24:00:00",   "1979-05-27T07:60:00", "1979-05-27T07:32:61", "1979-5-27",           "79-05-27",
+        "1979-05-27T07:32",      "07:32",               "7:32:00",             "1979-05-27T07:32:00.", "1979-05-27T07:32:00+25:00",
+        "1979-05-27T07:32:00+01", "1979-05-27X07:32:00", "1979-05-27T07:32:00ZZ",
+    };
+    char doc[64];
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        snprintf(doc, sizeof(doc), "a = %s\n", invalid[i]);
+        if (test_valid(doc)) {
+            fprintf(stderr, "accepted %s\n", invalid[i]);
+            CHECK(!"invalid datetime accepted");
+        }
+    }
+}
+
+int main(void) {
+    test_types();
+    test_fraction_digits();
+    test_invalid();
+    return TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+/**
+ * The toml-test JSON form written by the buffer dumpers.
+ */
+
+#include "mytoml_test.h"
+
+/* Dumps the value of `path` and compares it to `want`. */
+static void test_value(TomlKey *root, const char *path, const char *want) {
+    TomlKey *key = toml_get_path(root, path);
+    CHECK(key != NULL && key->value != NULL);
+    if (key == NULL || key->value == NULL) return;
+    char *s = (char *)toml_value_dumps(key->value);
+    if (s == NULL || strcmp(s, want) != 0) {
+        fprintf(stderr, "%s dumped as %s, expected %s\n", path, s ? s : "NULL", want);
+        CHECK(!"value dumped wrongly");
+    }
+    free(s);
+}
+
+static void test_values(void) {
+    TomlKey *root = test_parse(
+        "s = \"hi\"\ne = \"a\\\"b\\\\c\\n\\t\\b\"\nl = 'C:\\dir'\ni = -7\nf = 1.5\n"
+        "pinf = inf\nninf = -inf\nn = nan\nt = true\nd = 1979-05-27T07:32:00Z\nld = 1979-05-27\n");
+    CHECK(root != NULL);
+    test_value(root, "s", "{\"type\": \"string\", \"value\": \"hi\"}");
+    test_value(root, "e", "{\"type\": \"string\", \"value\": \"a\\\"b\\\\c\\n\\t\\b\"}");
+    test_value(root, "l", "{\"type\": \"string\", \"value\": \"C:\\\\dir\"}");
+    test_value(root, "i", "{\"type\": \"integer\", \"value\": \"-7\"}");
+    test_value(root, "f", "{\"type\": \"float\", \"value\": \"1.5\"}");
+    test_value(root, "pinf", "{\"type\": \"float\", \"value\": \"inf\"}");
+    test_value(root, "ninf", "{\"type\": \"float\", \"value\": \"-inf\"}");
+    test_value(root, "n", "{\"type\": \"float\", \"value\": \"nan\"}");
+    test_value(root, "t", "{\"type\": \"bool\", \"value\": \"true\"}");
+    test_value(root, "d", "{\"type\": \"datetime\", \"value\": \"1979-05-27T07:32:00Z\"}");
+    test_value(root, "ld", "{\"type\": \"date-local\", \"value\": \"1979-05-27\"}");
+    toml_free(root);
+}
+
+static void test_keys(void) {
+    TomlKey *root = test_parse("a = 1\n[t]\nb = [\"x\"]\n[[u]]\n");
+    CHECK(root != NULL);
+    char *s = (char *)toml_key_dumps(toml_get_path(root, "t"));
+    CHECK(s != NULL && strcmp(s, "\"t\": {\n\"b\": [\n{\"type\": \"string\", \"value\": \"x\"}\n]\n}") == 0);
+    free(s);
+    s = (char *)toml_key_dumps(toml_get_path(root, "a"));
+    CHECK(s != NULL && strcmp(s, "\"a\": {\"type\": \"integer\", \"value\": \"1\"}") == 0);
+    free(s);
+    toml_free(root);
+}
+
+static void test_buffer(void) {
+    TomlKey *root = test_parse("a = \"x\"\nb = 2\n");
+    CHECK(root != NULL);
+    const char *a = "\"a\": {\"type\": \"string\", \"value\": \"x\"}";
+    const char *b = "\"b\": {\"type\": \"integer\", \"value\": \"2\"}";
+    char *buffer = NULL;
+    size_t size = 0;
+    toml_dump_buffer(toml_get_path(root, "a"), &buffer, &size);
+    CHECK(buffer != NULL && size == strlen(a) && strcmp(buffer, a) == 0);
+    // a second dump is appended
+    toml_dump_buffer(toml_get_path(root, "b"), &buffer, &size);
+    CHECK(buffer != NULL && size == strlen(a) + strlen(b));
+    CHECK(buffer != NULL && strncmp(buffer, a, strlen(a)) == 0 && strcmp(buffer + strlen(a), b) == 0);
+    free(buffer);
+    toml_free(root);
+}
+
+static void test_large(void) {
+    // larger than the initial capacity of the buffer
+    int n = 5000;
+    char *doc = (char *)malloc((size_t)n * 16 + 16);
+    int len = sprintf(doc, "a = [");
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "\"%d\",", i);
+    sprintf(doc + len, "]\n");
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    char *s = (char *)toml_key_dumps(toml_get_path(root, "a"));
+    CHECK(s != NULL && strstr(s, "{\"type\": \"string\", \"value\": \"4999\"}\n]") != NULL);
+    free(s);
+    toml_free(root);
+    free(doc);
+}
+
+int main(void) {
+    test_values();
+    test_keys();
+    test_buffer();
+    test_large();
+    return TEST_RESULT();
+}
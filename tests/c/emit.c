@@ -0,0 +1,114 @@
+/**
+ * The TOML emitter writes documents that parse back to the same
+ * tree, up to the order of keys, since pairs are written before
+ * sections.
+ */
+
+#include "mytoml_test.h"
+
+static const char *documents[] = {
+    "a = 1\nb.c = \"x\"\nf = 0.1\ng = 1e300\nh = -inf\nn = nan\nz = -0.0\n",
+    "i = {x = 1, y.z = [1, 2], e = {}}\nd = 1979-05-27T07:32:00.5-07:00\nlt = 07:32:00\nld = 1979-05-27\n",
+    "\"key with space\" = true\n'quoted.dot' = 1\n\"\" = 2\n\"\\u00e9\\n\" = \"tab\\tquote\\\"\"\n",
+    "[t]\ns = \"\"\"ml\nline\"\"\"\nl = '''C:\\dir'''\n[t.u]\nv = []\nw = [[1, 2], [\"a\"], [{k = 1}]]\n",
+    "[[arr]]\nk = 1\n[[arr]]\n[arr.sub]\nq = 2\n[[arr.sub.deep]]\nr = 3\n[[arr]]\n",
+    "a.b.c = 1\na.b.d = 2\n[x.y]\nz = 1\n[x]\nw = 2\n",
+    "max = 9223372036854775807\nmin = -9223372036854775808\nsmall = 5e-324\npi = 3.141592653589793\n",
+};
+
+static bool test_same_key(TomlKey *a, TomlKey *b);
+
+/* Whether two values are equal, comparing scalars by their dump. */
+static bool test_same_value(TomlValue *a, TomlValue *b) {
+    if (a == NULL || b == NULL) return a == b;
+    if (a->type != b->type) return false;
+    if (a->type == TOML_INLINETABLE) return test_same_key(a->table, b->table);
+    if (a->type == TOML_ARRAY) {
+        if (a->len != b->len) return false;
+        for (int i = 0; i < a->len; i++) {
+            if (!test_same_value(a->arr[i], b->arr[i])) return false;
+        }
+        return true;
+    }
+    char *da = (char *)toml_value_dumps(a);
+    char *db = (char *)toml_value_dumps(b);
+    bool same = da != NULL && db != NULL && strcmp(da, db) == 0;
+    free(da);
+    free(db);
+    return same;
+}
+
+/* Whether two keys hold the same subkeys and values in any order. */
+static bool test_same_key(TomlKey *a, TomlKey *b) {
+    if (toml_key_count(a) != toml_key_count(b)) return false;
+    if ((a->value != NULL || b->value != NULL) && !test_same_value(a->value, b->value)) return false;
+    for (int i = 0; i < toml_key_count(a); i++) {
+        TomlKey *sub = toml_key_at(a, i);
+        TomlKey *other = toml_get_key(b, sub->id);
+        if (other == NULL || !test_same_key(sub, other)) return false;
+    }
+    return true;
+}
+
+/* Parses `toml`, emits it and parses the result again. */
+static void test_round_trip(const char *toml) {
+    TomlKey *root = test_parse(toml);
+    CHECK(root != NULL);
+    if (root == NULL) return;
+    char *emitted = NULL;
+    size_t size = 0;
+    toml_key_dump_toml_buffer(root, &emitted, &size);
+    CHECK(emitted != NULL);
+    TomlKey *again = emitted ? test_parse(emitted) : NULL;
+    CHECK(again != NULL);
+    if (again != NULL) {
+        if (!test_same_key(root, again)) {
+            fprintf(stderr, "round trip of:\n%s\nemitted:\n%s\n", toml, emitted);
+            CHECK(!"round trip changed the document");
+        }
+        // emitting is stable once a document went through it
+        char *twice = NULL;
+        size_t twice_size = 0;
+        toml_key_dump_toml_buffer(again, &twice, &twice_size);
+        CHECK(twice != NULL && twice_size == size && strcmp(twice, emitted) == 0);
+        free(twice);
+        toml_free(again);
+    }
+    free(emitted);
+    toml_free(root);
+}
+
+static void test_round_trips(void) {
+    for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) test_round_trip(documents[i]);
+}
+
+static void test_layout(void) {
+    TomlKey *root = test_parse("[t]\nx = 1\n[[a]]\ny = 2\n[s]\nz = {w = 3}\nb.c = 4\n");
+    CHECK(root != NULL);
+    char *emitted = NULL;
+    size_t size = 0;
+    toml_key_dump_toml_buffer(root, &emitted, &size);
+    const char *want = "[t]\nx = 1\n\n[[a]]\ny = 2\n\n[s]\nz = { w = 3 }\nb.c = 4\n";
+    if (emitted == NULL || strcmp(emitted, want) != 0) {
+        fprintf(stderr, "emitted:\n%s\n", emitted ? emitted : "NULL");
+        CHECK(!"unexpected layout");
+    }
+    free(emitted);
+    toml_free(root);
+}
+
+static void test_large(void) {
+    int n = 2000;
+    char *doc = (char *)malloc((size_t)n * 64);
+    int len = 0;
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "[[t]]\nid = %d\nname = \"n%d\"\nf = %d.25\n", i, i, i);
+    test_round_trip(doc);
+    free(doc);
+}
+
+int main(void) {
+    test_round_trips();
+    test_layout();
+    test_large();
+    return TEST_RESULT();
+}
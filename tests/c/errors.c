@@ -0,0 +1,115 @@
+/**
+ * Failures are reported through return values and TomlError_t,
+ * never printed.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+
+#include "mytoml_test.h"
+
+static void check_error(const char *doc, TomlErrorType type, int line, int column) {
+    TomlError_t err = {0};
+    TomlKey *root = toml_parse_ex(doc, strlen(doc), &err);
+    if (root != NULL || err.type != type || err.message == NULL || err.line != line ||
+        err.column != column) {
+        fprintf(stderr, "%s-> %d:%d %s, expected %d:%d\n", doc, err.line, err.column,
+                err.message ? err.message : "(null)", line, column);
+        CHECK(!"wrong error location");
+    }
+    toml_free(root);
+}
+
+static void test_error_locations(void) {
+    check_error("a = 1\nb = \n", MISSING_VALUE, 2, 5);
+    check_error("a = 1\na = 2\n", KEY_ALREADY_EXISTS, 2, 3);
+    check_error("x = 1979-13-01\n", TOML_DECODE, 1, 5);
+    check_error("a = 1 b = 2\n", TOML_DECODE, 1, 7);
+    check_error("a = 1\n[t\n", TOML_DECODE, 2, 3);
+    check_error("a = \"\\q\"\n", TOML_DECODE, 1, 5);
+    check_error("a = {b = 1,\n}\n", TOML_DECODE, 1, 12);
+    // lines inside multi-line strings and arrays are counted
+    check_error("a = \"\"\"\nx\ny\"\"\"\nb = ?\n", TOML_DECODE, 4, 5);
+    check_error("a = [\n  1,\n  ?\n]\n", TOML_DECODE, 3, 3);
+    check_error("a = 1\r\nb = 2\r\nc = ?\r\n", TOML_DECODE, 3, 5);
+    check_error("# c\n\n[t]\n[t]\n", KEY_ALREADY_EXISTS, 4, 3);
+}
+
+static void test_success_clears_error(void) {
+    TomlError_t err = {TOML_DECODE, "stale", 7, 7};
+    const char *doc = "a = 1\n";
+    TomlKey *root = toml_parse_ex(doc, strlen(doc), &err);
+    CHECK(root != NULL);
+    CHECK(err.type == TOML_OK);
+    toml_free(root);
+    // the error is optional
+    CHECK(toml_parse_ex("a = \n", 5, NULL) == NULL);
+}
+
+static void test_loads_n(void) {
+    // only the first len bytes are read, the slice needs no terminator
+    char buf[] = {'a', ' ', '=', ' ', '1', '2', '\n', 'b', ' ', '=', ' ', '?'};
+    TomlKey *root = toml_loads_n(buf, 7);
+    CHECK(root != NULL);
+    CHECK_INT(root, "a", 12);
+    CHECK(toml_get_key(root, "b") == NULL);
+    toml_free(root);
+    CHECK(toml_loads_n(buf, sizeof(buf)) == NULL);
+    // a slice may end right after a value but not inside one
+    root = toml_loads_n(buf, 5);
+    CHECK(root != NULL);
+    CHECK_INT(root, "a", 1);
+    toml_free(root);
+    CHECK(toml_loads_n("a = \"abc\"", 6) == NULL);
+    root = toml_loads_n("", 0);
+    CHECK(root != NULL && toml_key_count(root) == 0);
+    toml_free(root);
+}
+
+static void test_too_big(void) {
+    // the length is rejected before any byte is read
+    const char *doc = "a = 1\n";
+    size_t sizes[] = {MYTOML_MAX_FILE_SIZE, (size_t)INT_MAX + 2, SIZE_MAX};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        TomlError_t err = {0};
+        CHECK(toml_loads_n(doc, sizes[i]) == NULL);
+        CHECK(toml_parse_ex(doc, sizes[i], &err) == NULL && err.type == TOML_MEMORY);
+        err.type = TOML_OK;
+        CHECK(toml_parse_parallel(doc, sizes[i], 4, &err) == NULL && err.type == TOML_MEMORY);
+        TomlStream *stream = toml_stream_new();
+        CHECK(toml_stream_feed(stream, doc, strlen(doc)));
+        CHECK(!toml_stream_feed(stream, doc, sizes[i]));
+        err.type = TOML_OK;
+        CHECK(toml_stream_finish(stream, &err) == NULL && err.type == TOML_MEMORY && err.line == 2);
+    }
+}
+
+static void test_dump_failures(void) {
+    TomlKey *root = test_parse("a = 1\n");
+    CHECK(root != NULL);
+    CHECK(!toml_key_dump_file_name(root, "/nonexistent-dir/out.json"));
+    CHECK(!toml_value_dump_file_name(toml_get_key(root, "a")->value, "/nonexistent-dir/out.json"));
+    toml_free(root);
+}
+
+static void test_empty_buffer_dump(void) {
+    TomlKey *root = test_parse("");
+    CHECK(root != NULL);
+    char *buffer = NULL;
+    size_t size = 0;
+    toml_key_dump_toml_buffer(root, &buffer, &size);
+    // an empty document still gets a terminated buffer
+    CHECK(buffer != NULL && size == 0 && buffer[0] == '\0');
+    free(buffer);
+    toml_free(root);
+}
+
+int main(void) {
+    test_error_locations();
+    test_success_clears_error();
+    test_loads_n();
+    test_too_big();
+    test_dump_failures();
+    test_empty_buffer_dump();
+    return TEST_RESULT();
+}
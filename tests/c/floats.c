@@ -0,0 +1,77 @@
+/**
+ * Floats are converted from their token span, exactly when the
+ * mantissa and the power of ten fit in a double and through `strtod`
+ * otherwise. Every result must be the correctly rounded double.
+ */
+
+#include "mytoml_test.h"
+
+/* Compares the parsed `token` to the C library conversion of `digits`. */
+static void test_float(const char *token, const char *digits) {
+    char doc[128];
+    snprintf(doc, sizeof(doc), "a = %s\n", token);
+    TomlKey *root = test_parse(doc);
+    double *v = toml_get_float(toml_get_path(root, "a"));
+    double want = strtod(digits, NULL);
+    if (v == NULL || memcmp(v, &want, sizeof(want)) != 0) {
+        fprintf(stderr, "%s parsed as %.17g, expected %.17g\n", token, v ? *v : 0.0, want);
+        CHECK(!"float not correctly rounded");
+    }
+    toml_free(root);
+}
+
+static void test_fixed(void) {
+    test_float("1.0", "1.0");
+    test_float("3.1415926535897932384626433832795028841971", "3.1415926535897932384626433832795028841971");
+    test_float("1_000.000_1", "1000.0001");
+    test_float("-2.5e-3", "-2.5e-3");
+    test_float("6.02214076e+23", "6.02214076e23");
+    test_float("1E22", "1e22");
+    test_float("1e23", "1e23");
+    test_float("9007199254740993.0", "9007199254740993.0");
+    test_float("2.2250738585072011e-308", "2.2250738585072011e-308");
+    test_float("4.9406564584124654e-324", "4.9406564584124654e-324");
+    test_float("1.7976931348623157e308", "1.7976931348623157e308");
+    test_float("0.000000000000000000000000000001", "1e-30");
+    test_float("123456789012345678901234567890.0", "123456789012345678901234567890.0");
+    test_float("0.1e-99999", "0");
+    test_float("-0.0e0", "-0.0");
+}
+
+static void test_random(void) {
+    // at most 20 digits, a point and an exponent
+    char token[96], digits[24];
+    unsigned int seed = 12345;
+    for (int n = 0; n < 20000; n++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned long long mantissa = ((unsigned long long)seed << 20) ^ (seed >> 3);
+        int places = (int)(seed % 19);
+        int exponent = (int)((seed >> 8) % 600) - 300;
+        snprintf(digits, sizeof(digits), "%llu", mantissa % 100000000000000000ULL + 1);
+        int len = (int)strlen(digits);
+        if (places >= len) places = len - 1;
+        // insert a decimal point `places` digits from the end
+        snprintf(token, sizeof(token), "%.*s.%se%d", len - places, digits, digits + len - places, exponent);
+        if (places == 0) snprintf(token, sizeof(token), "%s.0e%d", digits, exponent);
+        test_float(token, token);
+    }
+}
+
+static void test_invalid(void) {
+    const char *invalid[] = {"1.", ".1", "1.e1", "1e", "1e+", "1.5e1.5", "1._5", "1_.5", "1e_1", "1.5_", "+.5", "1ee1", "1.0.0", "infinity", "NaN"};
+    char doc[64];
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        snprintf(doc, sizeof(doc), "a = %s\n", invalid[i]);
+        if (test_valid(doc)) {
+            fprintf(stderr, "accepted %s\n", invalid[i]);
+            CHECK(!"invalid float accepted");
+        }
+    }
+}
+
+int main(void) {
+    test_fixed();
+    test_random();
+    test_invalid();
+    return TEST_RESULT();
+}
@@ -0,0 +1,101 @@
+/**
+ * Inline tables are parsed straight into the table that owns them
+ * and are closed to later additions.
+ */
+
+#include "mytoml_test.h"
+
+static void test_inline_tables(void) {
+    TomlKey *root = test_parse(
+        "empty = {}\npoint = {x = 1, y = 2}\nnested = {a = {b = {c = 1}}, d.e = 2}\n"
+        "mixed = {s = \"x\", arr = [1, {z = 3}], dt = 1979-05-27}\n[t]\nin = {k = 'v'}\n");
+    CHECK(root != NULL);
+    TomlKey *empty = toml_get_key(root, "empty");
+    // the subkeys of an inline table belong to its key directly
+    CHECK(empty != NULL && empty->type == TOML_KEYLEAF && empty->value == NULL && toml_key_count(empty) == 0);
+    CHECK(toml_key_count(toml_get_key(root, "point")) == 2);
+    CHECK_INT(root, "point.x", 1);
+    CHECK_INT(root, "point.y", 2);
+    CHECK_INT(root, "nested.a.b.c", 1);
+    CHECK_INT(root, "nested.d.e", 2);
+    CHECK_STRING(root, "mixed.s", "x");
+    CHECK_INT(root, "mixed.arr[1].z", 3);
+    CHECK_STRING(root, "t.in.k", "v");
+    toml_free(root);
+}
+
+static void test_representation(void) {
+    TomlKey *root = test_parse("k = {a = 1}\narr = [{a = 1}]\n");
+    CHECK(root != NULL);
+    // an inline table assigned to a key keeps its members as subkeys
+    TomlKey *k = toml_get_key(root, "k");
+    CHECK(k != NULL && k->type == TOML_KEYLEAF && k->value == NULL && toml_key_count(k) == 1);
+    TomlKey *a = toml_get_key(k, "a");
+    CHECK(a != NULL && a->type == TOML_KEYLEAF && a->value != NULL && a->value->type == TOML_INT);
+    // inline tables inside arrays are values wrapping a key
+    TomlValue *arr = toml_get_array(toml_get_key(root, "arr"));
+    CHECK(arr != NULL && arr->len == 1);
+    if (arr != NULL && arr->len == 1) {
+        TomlValue *element = arr->arr[0];
+        CHECK(element->type == TOML_INLINETABLE && element->table != NULL);
+        CHECK(element->table != NULL && toml_get_int(toml_get_key(element->table, "a")) != NULL);
+    }
+    toml_free(root);
+}
+
+static void test_array_of_inline_tables(void) {
+    int n = 5000;
+    char *doc = (char *)malloc((size_t)n * 32 + 16);
+    int len = sprintf(doc, "points = [");
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "{x = %d, y = %d},", i, -i);
+    sprintf(doc + len, "]\n");
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    TomlValue *points = toml_get_array(toml_get_key(root, "points"));
+    CHECK(points != NULL && points->len == n);
+    for (int i = 0; points != NULL && i < points->len; i++) {
+        TomlValue *p = points->arr[i];
+        int64_t *x = toml_get_int(toml_get_key(p->table, "x"));
+        int64_t *y = toml_get_int(toml_get_key(p->table, "y"));
+        if (p->type != TOML_INLINETABLE || x == NULL || y == NULL || *x != i || *y != -i) {
+            CHECK(!"inline table element parsed wrongly");
+            break;
+        }
+    }
+    CHECK_INT(root, "points[4999].y", -4999);
+    toml_free(root);
+    free(doc);
+}
+
+static void test_invalid(void) {
+    const char *invalid[] = {
+        "a = {b = 1, b = 2}\n",
+        "a = {b.c = 1, b.c = 2}\n",
+        "a = {b = {c = 1}, b.d = 2}\n",
+        "a = {b = 1,}\n",
+        "a = {b = 1\n}\n",
+        "a = {,}\n",
+        "a = {b = 1 c = 2}\n",
+        "a = {b = 1}\na.c = 2\n",
+        "a = {b = 1}\n[a]\n",
+        "a = {b = 1}\n[a.c]\n",
+        "a = {b = 1}\n[[a]]\n",
+        "a = {b = {c = 1}}\n[a.b]\n",
+        "[a]\nb = 1\n[x]\na = {}\n[x.a]\n",
+        "a = {b = 1}\na = {c = 1}\n",
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (test_valid(invalid[i])) {
+            fprintf(stderr, "accepted %s", invalid[i]);
+            CHECK(!"invalid inline table accepted");
+        }
+    }
+}
+
+int main(void) {
+    test_inline_tables();
+    test_representation();
+    test_array_of_inline_tables();
+    test_invalid();
+    return TEST_RESULT();
+}
@@ -0,0 +1,68 @@
+/**
+ * Integers are parsed straight into 64-bit slots, so values past
+ * 2^53 are exact. Neither integers nor floats may have leading zeros.
+ */
+
+#include "mytoml_test.h"
+
+static void test_limits(void) {
+    TomlKey *root = test_parse(
+        "max = 9223372036854775807\nmin = -9223372036854775808\nbig = 9007199254740993\n"
+        "hex = 0xDEAD_beef\noct = 0o755\nbin = 0b1101\nzero = +0\nsep = 1_000_000\n"
+        "hexmax = 0x7fffffffffffffff\n");
+    CHECK(root != NULL);
+    CHECK_INT(root, "max", INT64_MAX);
+    CHECK_INT(root, "min", INT64_MIN);
+    CHECK_INT(root, "big", 9007199254740993LL);
+    CHECK_INT(root, "hex", 0xdeadbeefLL);
+    CHECK_INT(root, "oct", 0755);
+    CHECK_INT(root, "bin", 13);
+    CHECK_INT(root, "zero", 0);
+    CHECK_INT(root, "sep", 1000000);
+    CHECK_INT(root, "hexmax", INT64_MAX);
+    toml_free(root);
+}
+
+static void test_invalid_integers(void) {
+    const char *invalid[] = {
+        "9223372036854775808", "-9223372036854775809", "0x8000000000000000", "01", "-01", "+00",
+        "0x", "0x_1", "0xg", "-0x1", "+0o7", "0o8", "0b2", "1__0", "_1", "1_", "0B1", "0X1",
+    };
+    char doc[64];
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        snprintf(doc, sizeof(doc), "a = %s\n", invalid[i]);
+        if (test_valid(doc)) {
+            fprintf(stderr, "accepted %s\n", invalid[i]);
+            CHECK(!"invalid integer accepted");
+        }
+    }
+}
+
+static void test_leading_zeros(void) {
+    const char *invalid[] = {"01.5", "00.1", "-01.0", "+00.5", "01e1", "00e0", "0_1.0", "-00e1"};
+    char doc[64];
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        snprintf(doc, sizeof(doc), "a = %s\n", invalid[i]);
+        if (test_valid(doc)) {
+            fprintf(stderr, "accepted %s\n", invalid[i]);
+            CHECK(!"float with a leading zero accepted");
+        }
+    }
+    TomlKey *root = test_parse("a = 0.1\nb = 0e1\nc = -0.5\nd = 10.5\ne = 0.001\nf = 100e2\ng = +0.0\n");
+    CHECK(root != NULL);
+    CHECK_FLOAT(root, "a", 0.1);
+    CHECK_FLOAT(root, "b", 0.0);
+    CHECK_FLOAT(root, "c", -0.5);
+    CHECK_FLOAT(root, "d", 10.5);
+    CHECK_FLOAT(root, "e", 0.001);
+    CHECK_FLOAT(root, "f", 10000.0);
+    CHECK_FLOAT(root, "g", 0.0);
+    toml_free(root);
+}
+
+int main(void) {
+    test_limits();
+    test_invalid_integers();
+    test_leading_zeros();
+    return TEST_RESULT();
+}
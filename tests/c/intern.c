@@ -0,0 +1,69 @@
+/**
+ * Identifiers are interned per document, so every key of a given
+ * name shares one `id`.
+ */
+
+#include "mytoml_test.h"
+
+static void test_shared_ids(void) {
+    TomlKey *root = test_parse(
+        "[a]\nname = 1\n[b]\n\"name\" = 2\n[c]\n'name' = 3\n"
+        "[[e]]\nname = 5\n[[e]]\nname = 6\nf = {name = 7}\n");
+    CHECK(root != NULL);
+    const char *paths[] = {"b.name", "c.name", "e[0].name", "e[1].name", "e[1].f.name"};
+    TomlKey *first = toml_get_path(root, "a.name");
+    CHECK(first != NULL && strcmp(first->id, "name") == 0);
+    for (size_t i = 0; first != NULL && i < sizeof(paths) / sizeof(paths[0]); i++) {
+        TomlKey *k = toml_get_path(root, paths[i]);
+        CHECK(k != NULL && k->id == first->id);
+    }
+    CHECK_INT(root, "c.name", 3);
+    CHECK_INT(root, "e[1].f.name", 7);
+    toml_free(root);
+}
+
+static void test_distinct_ids(void) {
+    TomlKey *root = test_parse("a = 1\nA = 2\n\"a \" = 3\n\"\" = 4\nab = 5\nAaAa = 6\nBBBB = 7\n");
+    CHECK(root != NULL);
+    CHECK(toml_key_count(root) == 7);
+    CHECK_INT(root, "a", 1);
+    CHECK_INT(root, "A", 2);
+    CHECK_INT(root, "\"a \"", 3);
+    CHECK_INT(root, "\"\"", 4);
+    CHECK_INT(root, "AaAa", 6);
+    CHECK_INT(root, "BBBB", 7);
+    TomlKey *empty = toml_get_key(root, "");
+    CHECK(empty != NULL && empty->id[0] == '\0');
+    toml_free(root);
+}
+
+static void test_many_ids(void) {
+    int n = 20000;
+    char *doc = (char *)malloc((size_t)n * 40);
+    int len = 0;
+    // each name is used twice, in two tables
+    for (int t = 0; t < 2; t++) {
+        len += sprintf(doc + len, "[t%d]\n", t);
+        for (int i = 0; i < n / 2; i++) len += sprintf(doc + len, "id%d = %d\n", i, i);
+    }
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    TomlKey *t0 = toml_get_key(root, "t0");
+    TomlKey *t1 = toml_get_key(root, "t1");
+    CHECK(toml_key_count(t0) == n / 2 && toml_key_count(t1) == n / 2);
+    for (int i = 0; i < toml_key_count(t0); i++) {
+        if (toml_key_at(t0, i)->id != toml_key_at(t1, i)->id) {
+            CHECK(!"identifier interned twice");
+            break;
+        }
+    }
+    toml_free(root);
+    free(doc);
+}
+
+int main(void) {
+    test_shared_ids();
+    test_distinct_ids();
+    test_many_ids();
+    return TEST_RESULT();
+}
@@ -0,0 +1,62 @@
+/**
+ * The plain JSON dump writes values untagged.
+ */
+
+#include "mytoml_test.h"
+
+static void test_json(const char *toml, const char *want) {
+    TomlKey *root = test_parse(toml);
+    CHECK(root != NULL);
+    if (root == NULL) return;
+    char *json = NULL;
+    size_t size = 0;
+    toml_key_dump_json_buffer(root, &json, &size);
+    if (json == NULL || size != strlen(want) || strcmp(json, want) != 0) {
+        fprintf(stderr, "%s dumped as %s, expected %s\n", toml, json ? json : "NULL", want);
+        CHECK(!"unexpected JSON");
+    }
+    free(json);
+    toml_free(root);
+}
+
+static void test_values(void) {
+    test_json("", "{}");
+    test_json("a = 1\nb = -2.5\nc = true\nd = false\n", "{\"a\": 1, \"b\": -2.5, \"c\": true, \"d\": false}");
+    test_json("s = \"q\\\"b\\\\n\\n\\t\"\n", "{\"s\": \"q\\\"b\\\\n\\n\\t\"}");
+    test_json("a = inf\nb = -inf\nc = nan\n", "{\"a\": null, \"b\": null, \"c\": null}");
+    test_json("d = 1979-05-27T07:32:00Z\nt = 07:32:00\n", "{\"d\": \"1979-05-27T07:32:00Z\", \"t\": \"07:32:00\"}");
+    test_json("a = []\nb = [1, [2], {c = 3}]\n", "{\"a\": [], \"b\": [1, [2], {\"c\": 3}]}");
+    test_json("\"a b\" = 1\n\"q\\\"\" = 2\n", "{\"a b\": 1, \"q\\\"\": 2}");
+}
+
+static void test_tables(void) {
+    test_json("a.b = 1\n[t]\nx = 1\n[t.u]\n", "{\"a\": {\"b\": 1}, \"t\": {\"x\": 1, \"u\": {}}}");
+    test_json("[[p]]\nn = 1\n[[p]]\n[[p.q]]\nm = 2\n", "{\"p\": [{\"n\": 1}, {\"q\": [{\"m\": 2}]}]}");
+}
+
+static size_t test_sink(const char *data, size_t size, void *user) {
+    size_t *total = (size_t *)user;
+    (void)data;
+    *total += size;
+    return size;
+}
+
+static void test_callback(void) {
+    TomlKey *root = test_parse("a = [1, 2, 3]\n[t]\nb = \"x\"\n");
+    CHECK(root != NULL);
+    char *json = NULL;
+    size_t size = 0;
+    toml_key_dump_json_buffer(root, &json, &size);
+    size_t total = 0;
+    CHECK(toml_key_dump_json_callback(root, test_sink, &total));
+    CHECK(json != NULL && total == size);
+    free(json);
+    toml_free(root);
+}
+
+int main(void) {
+    test_values();
+    test_tables();
+    test_callback();
+    return TEST_RESULT();
+}
@@ -0,0 +1,84 @@
+/**
+ * Tokens of every kind are recognised by the token-level lexer,
+ * wherever they are cut by whitespace, comments or line ends.
+ */
+
+#include "mytoml_test.h"
+
+static void test_keys(void) {
+    TomlKey *root = test_parse(
+        "bare-key_1 = 1\n"
+        "\"basic key\" = 2\n"
+        "'literal key' = 3\n"
+        "dotted . \"quoted\" . key = 4\n"
+        "1234 = 5\n");
+    CHECK(root != NULL);
+    CHECK_INT(root, "bare-key_1", 1);
+    CHECK_INT(root, "\"basic key\"", 2);
+    CHECK_INT(root, "'literal key'", 3);
+    CHECK_INT(root, "dotted.quoted.key", 4);
+    CHECK_INT(root, "1234", 5);
+    toml_free(root);
+}
+
+static void test_headers(void) {
+    TomlKey *root = test_parse(
+        "[ table . sub ]  # comment\n"
+        "a = 1\n"
+        "[[ array ]]\n"
+        "b = 2\n"
+        "[[array]]\n"
+        "b = 3\n");
+    CHECK(root != NULL);
+    CHECK_INT(root, "table.sub.a", 1);
+    CHECK_INT(root, "array[0].b", 2);
+    CHECK_INT(root, "array[1].b", 3);
+    toml_free(root);
+}
+
+static void test_values(void) {
+    TomlKey *root = test_parse(
+        "int = -17\n"
+        "hex = 0xff\n"
+        "float = +1.5e3\n"
+        "yes = true\n"
+        "no = false\n"
+        "when = 1979-05-27 07:32:00Z\n"
+        "str = \"a # not a comment\"  # a comment\r\n"
+        "arr = [ 1, 2 , 3, ]\n"
+        "inline = { x = 1, y = { z = 2 } }\n");
+    CHECK(root != NULL);
+    CHECK_INT(root, "int", -17);
+    CHECK_INT(root, "hex", 255);
+    CHECK_FLOAT(root, "float", 1500.0);
+    bool *yes = toml_get_bool(toml_get_path(root, "yes"));
+    bool *no = toml_get_bool(toml_get_path(root, "no"));
+    CHECK(yes != NULL && *yes);
+    CHECK(no != NULL && !*no);
+    TomlDatetime *when = toml_get_datetime(toml_get_path(root, "when"));
+    CHECK(when != NULL && when->year == 1979 && when->hour == 7 && when->minute == 32);
+    CHECK_STRING(root, "str", "a # not a comment");
+    TomlValue *arr = toml_get_array(toml_get_path(root, "arr"));
+    CHECK(arr != NULL && arr->len == 3);
+    CHECK(arr != NULL && arr->arr[2]->type == TOML_INT && arr->arr[2]->integer == 3);
+    CHECK_INT(root, "inline.y.z", 2);
+    toml_free(root);
+}
+
+static void test_invalid(void) {
+    CHECK(!test_valid("a = \n"));
+    CHECK(!test_valid("= 1\n"));
+    CHECK(!test_valid("a b = 1\n"));
+    CHECK(!test_valid("[table\n"));
+    CHECK(!test_valid("[[array]\n"));
+    CHECK(!test_valid("a = 1 b = 2\n"));
+    CHECK(!test_valid("a = [1 2]\n"));
+}
+
+int main(void) {
+    test_keys();
+    test_headers();
+    test_values();
+    test_invalid();
+    return TEST_RESULT();
+}
@@ -0,0 +1,55 @@
+/**
+ * Decisions that need to look past the current character, such as
+ * telling CRLF from a lone carriage return or a closing `"""` from
+ * quotes inside a string, are made without rewinding the input.
+ */
+
+#include "mytoml_test.h"
+
+static void test_line_ends(void) {
+    TomlKey *root = test_parse("a = 1\r\nb = 2\r\n[t]\r\nc = 3");
+    CHECK(root != NULL);
+    CHECK_INT(root, "a", 1);
+    CHECK_INT(root, "b", 2);
+    CHECK_INT(root, "t.c", 3);
+    toml_free(root);
+    CHECK(!test_valid("a = 1\rb = 2\n"));
+}
+
+static void test_multiline_quotes(void) {
+    TomlKey *root = test_parse(
+        "a = \"\"\"x\"\"\"\"\n"
+        "b = \"\"\"x\"\"\"\"\"\n"
+        "c = '''x''''\n"
+        "d = '''x'''''\n"
+        "e = \"\"\"\"x\"\"\"\n"
+        "f = \"\"\"\n"
+        "one \"\" two\"\"\"\n"
+        "g = \"\"\n"
+        "h = ''\n");
+    CHECK(root != NULL);
+    CHECK_STRING(root, "a", "x\"");
+    CHECK_STRING(root, "b", "x\"\"");
+    CHECK_STRING(root, "c", "x'");
+    CHECK_STRING(root, "d", "x''");
+    CHECK_STRING(root, "e", "\"x");
+    CHECK_STRING(root, "f", "one \"\" two");
+    CHECK_STRING(root, "g", "");
+    CHECK_STRING(root, "h", "");
+    toml_free(root);
+    CHECK(!test_valid("a = \"\"\"x\"\"\"\"\"\"\n"));
+}
+
+static void test_line_ending_backslash(void) {
+    TomlKey *root = test_parse("s = \"\"\"one \\\r\n    two\"\"\"\n");
+    CHECK(root != NULL);
+    CHECK_STRING(root, "s", "one two");
+    toml_free(root);
+}
+
+int main(void) {
+    test_line_ends();
+    test_multiline_quotes();
+    test_line_ending_backslash();
+    return TEST_RESULT();
+}
@@ -0,0 +1,57 @@
+/**
+ * Checks shared by the behaviour tests of the C API. Each test is
+ * a program that runs its checks, reports every failed one on
+ * stderr and exits with EXIT_FAILURE if any failed.
+ */
+
+#ifndef MYTOML_TEST_H
+#define MYTOML_TEST_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mytoml/mytoml.h>
+
+static int mytoml_test_failures = 0;
+
+#define CHECK(COND)                                                                     \
+    do {                                                                                \
+        if (!(COND)) {                                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #COND);    \
+            mytoml_test_failures++;                                                     \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_INT(ROOT, PATH, VALUE)                                  \
+    do {                                                              \
+        int64_t *_v = toml_get_int(toml_get_path((ROOT), (PATH)));    \
+        CHECK(_v != NULL && *_v == (VALUE));                          \
+    } while (0)
+
+#define CHECK_FLOAT(ROOT, PATH, VALUE)                                \
+    do {                                                              \
+        double *_v = toml_get_float(toml_get_path((ROOT), (PATH)));   \
+        CHECK(_v != NULL && *_v == (VALUE));                          \
+    } while (0)
+
+#define CHECK_STRING(ROOT, PATH, VALUE)                               \
+    do {                                                              \
+        char *_v = toml_get_string(toml_get_path((ROOT), (PATH)));    \
+        CHECK(_v != NULL && strcmp(_v, (VALUE)) == 0);                \
+    } while (0)
+
+#define TEST_RESULT() (mytoml_test_failures ? EXIT_FAILURE : EXIT_SUCCESS)
+
+/* Parses a NUL terminated document, NULL if it is invalid. */
+static inline TomlKey *test_parse(const char *toml) { return toml_parse_ex(toml, strlen(toml), NULL); }
+
+/* Whether a NUL terminated document is valid TOML. */
+static inline bool test_valid(const char *toml) {
+    TomlKey *root = test_parse(toml);
+    toml_free(root);
+    return root != NULL;
+}
+
+#endif  // MYTOML_TEST_H
@@ -0,0 +1,90 @@
+/**
+ * Subkeys are kept in the order they first appear in the document,
+ * so iterating and dumping a table is reproducible.
+ */
+
+#include "mytoml_test.h"
+
+static void test_order(const char *toml, const char *path, const char **ids, int n) {
+    TomlKey *root = test_parse(toml);
+    CHECK(root != NULL);
+    TomlKey *key = path ? toml_get_path(root, path) : root;
+    CHECK(toml_key_count(key) == n);
+    int i = 0;
+    TomlKey *sub;
+    toml_key_foreach(sub, key) {
+        if (i >= n || strcmp(sub->id, ids[i]) != 0) {
+            fprintf(stderr, "subkey %d of %s is %s, expected %s\n", i, path ? path : "root", sub->id, i < n ? ids[i] : "none");
+            CHECK(!"subkey out of order");
+            break;
+        }
+        i++;
+    }
+    CHECK(i == n);
+    toml_free(root);
+}
+
+static void test_orders(void) {
+    const char *flat[] = {"zeta", "alpha", "mid", "beta"};
+    test_order("zeta = 1\nalpha = 2\nmid = 3\nbeta = 4\n", NULL, flat, 4);
+    // a table is placed where it is first mentioned, implicitly or not
+    const char *tables[] = {"b", "a", "c"};
+    test_order("[b.x]\n[a]\n[b]\ny = 1\n[c]\n", NULL, tables, 3);
+    const char *sub[] = {"x", "y"};
+    test_order("[b.x]\n[a]\n[b]\ny = 1\n[c]\n", "b", sub, 2);
+    const char *dotted[] = {"q", "p", "r"};
+    test_order("t.q = 1\nt.p.x = 2\nt.r = 3\nt.p.y = 4\n", "t", dotted, 3);
+    const char *inline_[] = {"c", "a", "b"};
+    test_order("t = {c = 1, a = 2, b = {x = 1}}\n", "t", inline_, 3);
+}
+
+static void test_large_order(void) {
+    // order survives the hash index of a large table
+    int n = 1000;
+    char *doc = (char *)malloc((size_t)n * 24);
+    const char **ids = (const char **)malloc(sizeof(char *) * n);
+    char *names = (char *)malloc((size_t)n * 8);
+    int len = 0;
+    for (int i = 0; i < n; i++) {
+        int j = (i * 7919) % n;
+        sprintf(names + i * 8, "k%d", j);
+        ids[i] = names + i * 8;
+        len += sprintf(doc + len, "k%d = %d\n", j, i);
+    }
+    test_order(doc, NULL, ids, n);
+    free(names);
+    free(ids);
+    free(doc);
+}
+
+static void test_key_at(void) {
+    TomlKey *root = test_parse("a = 1\nb = 2\n");
+    CHECK(root != NULL);
+    CHECK(toml_key_at(root, -1) == NULL);
+    CHECK(toml_key_at(root, 2) == NULL);
+    CHECK(toml_key_at(root, 1) == toml_get_key(root, "b"));
+    CHECK(toml_key_count(toml_get_key(root, "a")) == 0);
+    CHECK(toml_key_at(toml_get_key(root, "a"), 0) == NULL);
+    CHECK(toml_key_count(NULL) == 0);
+    CHECK(toml_key_at(NULL, 0) == NULL);
+    toml_free(root);
+}
+
+static void test_dump_order(void) {
+    TomlKey *root = test_parse("z = 1\ny = 2\nx = 3\n");
+    CHECK(root != NULL);
+    char *json = NULL;
+    size_t size = 0;
+    toml_key_dump_json_buffer(root, &json, &size);
+    CHECK(json != NULL && strcmp(json, "{\"z\": 1, \"y\": 2, \"x\": 3}") == 0);
+    free(json);
+    toml_free(root);
+}
+
+int main(void) {
+    test_orders();
+    test_large_order();
+    test_key_at();
+    test_dump_order();
+    return TEST_RESULT();
+}
@@ -0,0 +1,81 @@
+/**
+ * toml_parse_parallel() gives the same document, or the same error,
+ * as a sequential parse.
+ */
+
+#include "mytoml_test.h"
+
+// large enough for several default sized chunks
+#define DOC_SIZE (3 * 1048576)
+
+static char *make_doc(const char *extra, size_t *len) {
+    char *doc = (char *)malloc(DOC_SIZE + 4096);
+    size_t n = 0;
+    for (int i = 0; n < DOC_SIZE; i++) {
+        // headers hidden in strings, comments and multi-line values
+        // must never be taken as places to cut
+        n += (size_t)sprintf(doc + n,
+                             "[t%d]\nx = %d\ns = \"\"\"\n[not.a.table]\n\"\"\"\n"
+                             "a = [\n[1],\n[2]\n]\n# [comment]\n[[arr]]\nk = %d\n[t%d.sub]\ny = 'z'\n%s",
+                             i, i, i, i, extra);
+    }
+    *len = n;
+    return doc;
+}
+
+static char *dump(TomlKey *root) {
+    char *buffer = NULL;
+    size_t size = 0;
+    toml_key_dump_json_buffer(root, &buffer, &size);
+    return buffer;
+}
+
+static void check_same(const char *doc, size_t len, int threads) {
+    TomlError_t seq_err = {0}, par_err = {0};
+    TomlKey *seq = toml_parse_ex(doc, len, &seq_err);
+    TomlKey *par = toml_parse_parallel(doc, len, threads, &par_err);
+    CHECK((seq == NULL) == (par == NULL));
+    CHECK(seq_err.type == par_err.type && seq_err.line == par_err.line && seq_err.column == par_err.column);
+    if (seq != NULL && par != NULL) {
+        char *a = dump(seq), *b = dump(par);
+        CHECK(a != NULL && b != NULL && strcmp(a, b) == 0);
+        free(a);
+        free(b);
+    }
+    toml_free(seq);
+    toml_free(par);
+}
+
+static void test_same_document(void) {
+    size_t len;
+    char *doc = make_doc("", &len);
+    check_same(doc, len, 4);
+    // one thread per processor
+    check_same(doc, len, 0);
+    check_same(doc, len, -1);
+    // small documents are parsed sequentially
+    check_same(doc, 4096, 4);
+    free(doc);
+    // a multi-line string closed with more than three quotes
+    doc = make_doc("a = [\"\"\"x\"\"\"\", [1,\n2],\n[3]]\nb = 1\n", &len);
+    check_same(doc, len, 4);
+    free(doc);
+}
+
+static void test_same_error(void) {
+    size_t len;
+    char *doc = make_doc("", &len);
+    // a re-defined table far from the first definition
+    memcpy(doc + len, "[t1]\n", 5);
+    check_same(doc, len + 5, 4);
+    // a syntax error in the middle of the document
+    doc[len / 2] = '=';
+    check_same(doc, len, 4);
+    free(doc);
+}
+
+int main(void) {
+    test_same_document();
+    test_same_error();
+    return TEST_RESULT();
+}
@@ -0,0 +1,79 @@
+/**
+ * Dotted paths, compiled once or on every lookup.
+ */
+
+#include "mytoml_test.h"
+
+static const char *document =
+    "title = \"t\"\n"
+    "[server]\nport = 8080\ntls.cert = \"c\"\n"
+    "[\"a.b\"]\n'c d' = 1\n\"q\\\"\" = 2\n"
+    "[[fruit]]\nname = \"apple\"\n[[fruit]]\nname = \"banana\"\n[[fruit.variety]]\nname = \"plantain\"\n"
+    "[inline]\nlist = [{x = 1}, {x = 2}]\nnums = [1, 2]\n";
+
+static void test_lookups(void) {
+    TomlKey *root = test_parse(document);
+    CHECK(root != NULL);
+    CHECK_STRING(root, "title", "t");
+    CHECK_INT(root, "server.port", 8080);
+    CHECK_INT(root, " server . port ", 8080);
+    CHECK_STRING(root, "server.tls.cert", "c");
+    CHECK_INT(root, "\"a.b\".'c d'", 1);
+    CHECK_INT(root, "'a.b'.\"q\\\"\"", 2);
+    CHECK_STRING(root, "fruit[0].name", "apple");
+    CHECK_STRING(root, "fruit[1].name", "banana");
+    CHECK_STRING(root, "fruit[1].variety[0].name", "plantain");
+    CHECK_INT(root, "inline.list[1].x", 2);
+    CHECK(toml_get_path(root, "server") != NULL);
+    CHECK(toml_get_path(root, "missing") == NULL);
+    CHECK(toml_get_path(root, "server.missing") == NULL);
+    CHECK(toml_get_path(root, "title.deeper") == NULL);
+    CHECK(toml_get_path(root, "fruit[2].name") == NULL);
+    CHECK(toml_get_path(root, "fruit[0].variety[0]") == NULL);
+    // scalar elements are values, not keys
+    CHECK(toml_get_path(root, "inline.nums[0]") == NULL);
+    CHECK(toml_get_path(root, "title[0]") == NULL);
+    CHECK(toml_get_path(NULL, "title") == NULL);
+    toml_free(root);
+}
+
+static void test_invalid_paths(void) {
+    const char *invalid[] = {"", ".", "a.", ".a", "a..b", "a b", "\"a", "'a", "a[", "a[]", "a[x]", "a[0", "a[0]b", "\"\\q\"", "a!"};
+    TomlKey *root = test_parse("a = 1\n");
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (toml_path_compile(invalid[i]) != NULL) {
+            fprintf(stderr, "compiled %s\n", invalid[i]);
+            CHECK(!"invalid path compiled");
+        }
+        CHECK(toml_get_path(root, invalid[i]) == NULL);
+    }
+    CHECK(toml_path_compile(NULL) == NULL);
+    CHECK(toml_path_get(root, NULL) == NULL);
+    toml_free(root);
+}
+
+static void test_compiled(void) {
+    TomlPath *path = toml_path_compile("fruit[1].name");
+    CHECK(path != NULL);
+    // a compiled path holds no pointers into a document
+    for (int i = 0; i < 3; i++) {
+        TomlKey *root = test_parse(document);
+        CHECK(root != NULL);
+        char *name = toml_get_string(toml_path_get(root, path));
+        CHECK(name != NULL && strcmp(name, "banana") == 0);
+        toml_free(root);
+    }
+    TomlKey *other = test_parse("[[fruit]]\n[[fruit]]\nname = \"cherry\"\n");
+    char *name = toml_get_string(toml_path_get(other, path));
+    CHECK(name != NULL && strcmp(name, "cherry") == 0);
+    toml_free(other);
+    toml_path_free(path);
+    toml_path_free(NULL);
+}
+
+int main(void) {
+    test_lookups();
+    test_invalid_paths();
+    test_compiled();
+    return TEST_RESULT();
+}
@@ -0,0 +1,72 @@
+/**
+ * Whitespace, comments and string bodies are scanned many bytes at
+ * a time. Interesting bytes are found at every offset within and
+ * across those blocks.
+ */
+
+#include "mytoml_test.h"
+
+#define MAX_RUN 80
+
+static void test_whitespace_runs(void) {
+    char doc[MAX_RUN * 2 + 32];
+    for (int n = 0; n < MAX_RUN; n++) {
+        int len = 0;
+        for (int i = 0; i < n; i++) doc[len++] = (i % 3) ? ' ' : '\t';
+        len += sprintf(doc + len, "a =");
+        for (int i = 0; i < n; i++) doc[len++] = ' ';
+        sprintf(doc + len, "%d\n", n);
+        TomlKey *root = test_parse(doc);
+        CHECK(root != NULL);
+        CHECK_INT(root, "a", n);
+        toml_free(root);
+    }
+}
+
+static void test_comment_runs(void) {
+    char doc[MAX_RUN + 32];
+    for (int n = 0; n < MAX_RUN; n++) {
+        int len = sprintf(doc, "a = 1 #");
+        for (int i = 0; i < n; i++) doc[len++] = (char)('a' + i % 26);
+        sprintf(doc + len, "\nb = 2\n");
+        TomlKey *root = test_parse(doc);
+        CHECK(root != NULL);
+        CHECK_INT(root, "b", 2);
+        toml_free(root);
+        // control characters are not allowed in comments
+        doc[7 + n / 2] = '\x01';
+        CHECK(n == 0 || !test_valid(doc));
+    }
+}
+
+static void test_string_runs(void) {
+    char doc[MAX_RUN + 32], want[MAX_RUN + 2];
+    for (int n = 0; n < MAX_RUN; n++) {
+        int len = sprintf(doc, "s = \"");
+        for (int i = 0; i < n; i++) doc[len++] = want[i] = (char)('a' + i % 26);
+        // an escape right after the run
+        sprintf(doc + len, "\\\"x\"\n");
+        want[n] = '"';
+        want[n + 1] = 'x';
+        want[n + 2] = '\0';
+        TomlKey *root = test_parse(doc);
+        CHECK(root != NULL);
+        CHECK_STRING(root, "s", want);
+        toml_free(root);
+        // a raw newline ends a basic string early
+        doc[5 + n] = '\n';
+        CHECK(!test_valid(doc));
+        // control characters are not allowed in literal strings either
+        len = sprintf(doc, "s = '");
+        for (int i = 0; i < n; i++) doc[len++] = 'b';
+        sprintf(doc + len, "\x02'\n");
+        CHECK(!test_valid(doc));
+    }
+}
+
+int main(void) {
+    test_whitespace_runs();
+    test_comment_runs();
+    test_string_runs();
+    return TEST_RESULT();
+}
@@ -0,0 +1,83 @@
+/**
+ * A document fed to toml_stream_feed() in pieces cut anywhere parses
+ * to the same document, or the same error, as toml_parse_ex().
+ */
+
+#include "mytoml_test.h"
+
+static const char *docs[] = {
+    "a = 1\nb = \"two\"\n[t]\nc = [1, 2,\n3]\nd = {e = 1}\n[[arr]]\nf = 1979-05-27T07:32:00Z\n",
+    // multi-line strings may end with one or two quotes of their own
+    "a = [\"\"\"x\"\"\"\", [1,\n2],\n3]\nb = 1\n",
+    "a = \"\"\"x\"\"\"\"\"\nb = '''\ny''''\nc = '''z'''''\nd = [\n'''w''''\n]\n",
+    "a = \"\"\"\n[t]\n# x\n\"\"\"\nb = '''\n\"\"\"\n'''\nc = \"\"\"\\\n  \"\"\"\n",
+    "# [t]\na = [ # ]\n1, # [\n2]\n[t] # ]\nb = {c = '[', d = \"]\"}\n",
+    "a = 1\r\nb = [\r\n2]\r\n",
+    "a = 1",
+    "",
+    // errors keep their place in the whole document
+    "a = 1\nb = [\n1,\n?]\n",
+    "a = \"\"\"x\"\"\"\"\"\"\nb = 1\n",
+    "a = 1\n[t]\nb = 2\n[t]\n",
+    "a = \"\"\"\nx\n",
+};
+
+static char *dump(TomlKey *root) {
+    char *buffer = NULL;
+    size_t size = 0;
+    toml_key_dump_json_buffer(root, &buffer, &size);
+    return buffer;
+}
+
+static TomlKey *feed(const char *doc, size_t len, size_t piece, TomlError_t *err) {
+    TomlStream *stream = toml_stream_new();
+    for (size_t pos = 0; pos < len; pos += piece) {
+        size_t n = (len - pos < piece) ? len - pos : piece;
+        if (!toml_stream_feed(stream, doc + pos, n)) break;
+    }
+    return toml_stream_finish(stream, err);
+}
+
+static void test_same_as_parse(void) {
+    for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+        size_t len = strlen(docs[i]);
+        TomlError_t expected = {0};
+        TomlKey *root = toml_parse_ex(docs[i], len, &expected);
+        char *want = root ? dump(root) : NULL;
+        for (size_t piece = 1; piece <= 10; piece++) {
+            TomlError_t err = {0};
+            TomlKey *got = feed(docs[i], len, piece, &err);
+            char *have = got ? dump(got) : NULL;
+            if ((want == NULL) != (have == NULL) || (want && strcmp(want, have) != 0) ||
+                err.type != expected.type || err.line != expected.line || err.column != expected.column) {
+                fprintf(stderr, "%s-> in pieces of %zu: %d:%d %s, expected %d:%d %s\n", docs[i], piece, err.line,
+                        err.column, err.message ? err.message : "", expected.line, expected.column,
+                        expected.message ? expected.message : "");
+                CHECK(!"stream differs from toml_parse_ex");
+            }
+            free(have);
+            toml_free(got);
+        }
+        free(want);
+        toml_free(root);
+    }
+}
+
+static void test_closing_quotes(void) {
+    TomlKey *root = test_parse(docs[1]);
+    CHECK(root != NULL);
+    TomlValue *a = toml_get_array(toml_get_key(root, "a"));
+    CHECK(a != NULL && a->len == 3);
+    if (a != NULL && a->len == 3) {
+        CHECK(a->arr[0]->type == TOML_STRING && strcmp(a->arr[0]->str, "x\"") == 0);
+        CHECK(a->arr[1]->type == TOML_ARRAY && a->arr[1]->len == 2);
+    }
+    CHECK_INT(root, "b", 1);
+    toml_free(root);
+}
+
+int main(void) {
+    test_same_as_parse();
+    test_closing_quotes();
+    return TEST_RESULT();
+}
@@ -0,0 +1,81 @@
+/**
+ * String values are decoded into buffers sized from their token,
+ * so they have no length limit. Number tokens are still limited to
+ * `MYTOML_MAX_NUMBER_LENGTH` bytes.
+ */
+
+#include "mytoml_test.h"
+
+#define LONG_LENGTH 10000
+
+static char *test_long_document(const char *open, const char *body, const char *close, int n) {
+    size_t size = strlen(open) + strlen(close) + (size_t)n * strlen(body) + 8;
+    char *doc = (char *)malloc(size);
+    int len = sprintf(doc, "s = %s", open);
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "%s", body);
+    sprintf(doc + len, "%s\n", close);
+    return doc;
+}
+
+static void test_long_string(const char *open, const char *body, const char *close, const char *decoded) {
+    char *doc = test_long_document(open, body, close, LONG_LENGTH);
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    TomlKey *key = toml_get_path(root, "s");
+    char *s = toml_get_string(key);
+    TomlValue *v = key ? key->value : NULL;
+    size_t step = strlen(decoded);
+    CHECK(s != NULL && v->len == (int)(LONG_LENGTH * step));
+    for (size_t i = 0; s != NULL && i < LONG_LENGTH; i++) {
+        if (memcmp(s + i * step, decoded, step) != 0) {
+            CHECK(!"long string decoded wrongly");
+            break;
+        }
+    }
+    toml_free(root);
+    free(doc);
+}
+
+static void test_long_strings(void) {
+    test_long_string("\"", "abc", "\"", "abc");
+    test_long_string("\"", "a\\tb", "\"", "a\tb");
+    test_long_string("\"", "\\u00e9", "\"", "\xc3\xa9");
+    test_long_string("'", "a\\b", "'", "a\\b");
+    test_long_string("\"\"\"", "line\n", "\"\"\"", "line\n");
+    test_long_string("'''", "line\r\n", "'''", "line\n");
+}
+
+static void test_escapes(void) {
+    TomlKey *root = test_parse("a = \"\"\nb = ''\nc = \"\\\\\"\nd = \"\"\"\\\n   x\"\"\"\ne = \"\\U0001F600\"\n");
+    CHECK(root != NULL);
+    CHECK_STRING(root, "a", "");
+    CHECK_STRING(root, "b", "");
+    CHECK_STRING(root, "c", "\\");
+    CHECK_STRING(root, "d", "x");
+    CHECK_STRING(root, "e", "\xf0\x9f\x98\x80");
+    toml_free(root);
+    CHECK(!test_valid("a = \"\\q\"\n"));
+    CHECK(!test_valid("a = \"\\uD800\"\n"));
+    CHECK(!test_valid("a = \"abc\n"));
+}
+
+static void test_number_length(void) {
+    char *doc = test_long_document("", "0", "1", MYTOML_MAX_NUMBER_LENGTH / 2);
+    doc[4] = '1';
+    doc[5] = '.';
+    TomlKey *root = test_parse(doc);
+    CHECK(root != NULL);
+    CHECK_FLOAT(root, "s", 1.0);
+    toml_free(root);
+    free(doc);
+    doc = test_long_document("1.", "0", "", MYTOML_MAX_NUMBER_LENGTH);
+    CHECK(!test_valid(doc));
+    free(doc);
+}
+
+int main(void) {
+    test_long_strings();
+    test_escapes();
+    test_number_length();
+    return TEST_RESULT();
+}
@@ -0,0 +1,92 @@
+/**
+ * Tables are searched linearly while small and through a hash index
+ * once they hold more than `MYTOML_TABLE_INDEX_THRESHOLD` subkeys.
+ */
+
+#include "mytoml_test.h"
+
+#define TABLE_SIZES 4
+
+static const int sizes[TABLE_SIZES] = {1, MYTOML_TABLE_INDEX_THRESHOLD, MYTOML_TABLE_INDEX_THRESHOLD + 1, 5000};
+
+static char *test_table_document(int n, const char *header) {
+    char *doc = (char *)malloc((size_t)n * 32 + 64);
+    int len = sprintf(doc, "%s", header);
+    for (int i = 0; i < n; i++) len += sprintf(doc + len, "key%d = %d\n", i, i);
+    return doc;
+}
+
+static void test_lookups(void) {
+    for (int s = 0; s < TABLE_SIZES; s++) {
+        int n = sizes[s];
+        char *doc = test_table_document(n, "[t]\n");
+        TomlKey *root = test_parse(doc);
+        CHECK(root != NULL);
+        TomlKey *t = toml_get_key(root, "t");
+        CHECK(toml_key_count(t) == n);
+        char path[32];
+        for (int i = 0; i < n; i++) {
+            snprintf(path, sizeof(path), "t.key%d", i);
+            CHECK_INT(root, path, i);
+            snprintf(path, sizeof(path), "key%d", i);
+            TomlKey *k = toml_get_key(t, path);
+            CHECK(k != NULL && toml_key_at(t, i) == k);
+        }
+        CHECK(toml_get_key(t, "key") == NULL);
+        CHECK(toml_get_path(root, "t.missing") == NULL);
+        toml_free(root);
+        free(doc);
+    }
+}
+
+static void test_duplicates(void) {
+    for (int s = 0; s < TABLE_SIZES; s++) {
+        int n = sizes[s];
+        char *doc = test_table_document(n, "");
+        // redefine the first and the last key
+        char *last = doc + strlen(doc);
+        sprintf(last, "key0 = 1\n");
+        CHECK(!test_valid(doc));
+        sprintf(last, "key%d = 1\n", n - 1);
+        CHECK(!test_valid(doc));
+        sprintf(last, "key%d = 1\n", n);
+        CHECK(test_valid(doc));
+        free(doc);
+    }
+}
+
+static void test_collisions(void) {
+    // "Aa" and "BB", and their concatenations, share a hash
+    const char *ids[] = {"AaAa", "AaBB", "BBAa", "BBBB"};
+    for (int s = 0; s < TABLE_SIZES; s++) {
+        char *doc = test_table_document(sizes[s], "");
+        char *last = doc + strlen(doc);
+        for (int i = 0; i < 4; i++) last += sprintf(last, "%s = %d\n", ids[i], i);
+        TomlKey *root = test_parse(doc);
+        CHECK(root != NULL);
+        for (int i = 0; i < 4; i++) CHECK_INT(root, ids[i], i);
+        CHECK(toml_get_key(root, "AaAb") == NULL);
+        toml_free(root);
+        sprintf(last, "BBAa = 1\n");
+        CHECK(!test_valid(doc));
+        free(doc);
+    }
+}
+
+static void test_array_table_index(void) {
+    TomlKey *root = test_parse("[[a]]\n[[a]]\n[b]\n");
+    CHECK(root != NULL);
+    TomlKey *a = toml_get_key(root, "a");
+    TomlKey *b = toml_get_key(root, "b");
+    CHECK(a != NULL && a->type == TOML_ARRAYTABLE && a->idx == 1);
+    CHECK(b != NULL && b->idx == TOML_KEY_NO_INDEX);
+    toml_free(root);
+}
+
+int main(void) {
+    test_lookups();
+    test_duplicates();
+    test_collisions();
+    test_array_table_index();
+    return TEST_RESULT();
+}
@@ -0,0 +1,65 @@
+/**
+ * Scalars live inline in their TomlValue, strings are a pointer and
+ * a length.
+ */
+
+#include "mytoml_test.h"
+
+static void test_layout(void) {
+    CHECK(sizeof(TomlValue) <= 24);
+    CHECK(sizeof(TomlDatetime) <= 16);
+}
+
+static void test_scalars(void) {
+    TomlKey *root = test_parse("i = -42\nf = 6.25\ng = 5e+22\nt = true\nn = false\ns = \"a\\tb\"\n");
+    CHECK(root != NULL);
+    TomlKey *i = toml_get_path(root, "i");
+    CHECK(i != NULL && i->value->type == TOML_INT && toml_get_int(i) == &i->value->integer && i->value->integer == -42);
+    TomlKey *f = toml_get_path(root, "f");
+    CHECK(f != NULL && f->value->type == TOML_FLOAT && toml_get_float(f) == &f->value->number);
+    CHECK(f != NULL && f->value->number == 6.25 && f->value->precision == 2 && !f->value->scientific);
+    TomlKey *g = toml_get_path(root, "g");
+    CHECK(g != NULL && g->value->number == 5e22 && g->value->scientific);
+    TomlKey *t = toml_get_path(root, "t");
+    CHECK(t != NULL && t->value->type == TOML_BOOL && toml_get_bool(t) != NULL && *toml_get_bool(t));
+    TomlKey *n = toml_get_path(root, "n");
+    CHECK(n != NULL && toml_get_bool(n) != NULL && !*toml_get_bool(n));
+    TomlKey *s = toml_get_path(root, "s");
+    CHECK(s != NULL && s->value->type == TOML_STRING && s->value->len == 3 && memcmp(s->value->str, "a\tb", 4) == 0);
+    toml_free(root);
+}
+
+static void test_mismatched_getters(void) {
+    TomlKey *root = test_parse("i = 1\ns = \"x\"\n[t]\n");
+    CHECK(root != NULL);
+    CHECK(toml_get_float(toml_get_path(root, "i")) == NULL);
+    CHECK(toml_get_string(toml_get_path(root, "i")) == NULL);
+    CHECK(toml_get_int(toml_get_path(root, "s")) == NULL);
+    CHECK(toml_get_bool(toml_get_path(root, "s")) == NULL);
+    CHECK(toml_get_datetime(toml_get_path(root, "s")) == NULL);
+    CHECK(toml_get_int(toml_get_path(root, "t")) == NULL);
+    CHECK(toml_get_int(NULL) == NULL);
+    toml_free(root);
+}
+
+static void test_special_floats(void) {
+    TomlKey *root = test_parse("a = inf\nb = -inf\nc = nan\nd = -0.0\n");
+    CHECK(root != NULL);
+    double *a = toml_get_float(toml_get_path(root, "a"));
+    double *b = toml_get_float(toml_get_path(root, "b"));
+    double *c = toml_get_float(toml_get_path(root, "c"));
+    double *d = toml_get_float(toml_get_path(root, "d"));
+    CHECK(a != NULL && *a > 0 && *a * 0.5 == *a);
+    CHECK(b != NULL && *b < 0 && *b * 0.5 == *b);
+    CHECK(c != NULL && *c != *c);
+    CHECK(d != NULL && *d == 0.0 && 1.0 / *d < 0);
+    toml_free(root);
+}
+
+int main(void) {
+    test_layout();
+    test_scalars();
+    test_mismatched_getters();
+    test_special_floats();
+    return TEST_RESULT();
+}